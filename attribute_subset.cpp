@@ -1,22 +1,101 @@
 #include "attribute_subset.h"
-#include "experiment_random.h"
+#include "other/metrics.h"
 #include <algorithm>
 #include <iostream>
 using namespace std;
 
 namespace {
 
-std::vector<int> sample_dimensions(const std::set<int>& set_final_dimensions, int final_d, int d_hat_2, std::mt19937& generator, std::uniform_int_distribution<int>& distribution){
+// upper limit on the number of d_hat_2-subsets that are enumerated explicitly
+const long long MAX_ENUMERATED_SUBSETS = 4096;
+// number of rejected draws before a random subset is accepted even if it has been tried
+const int MAX_SAMPLING_ATTEMPTS = 64;
+// stop once this many consecutive rounds did not add a new point to the union
+const int MAX_STALLED_ROUNDS = 5;
+// hard limit on the number of rounds
+const int MAX_ROUNDS = 50;
+
+long long count_subsets(int n, int k){
+    // C(n, k), capped just above MAX_ENUMERATED_SUBSETS
+    long long count = 1;
+    for (int i = 1; i <= k; ++i){
+        count = count * (n - k + i) / i;
+        if (count > MAX_ENUMERATED_SUBSETS) return MAX_ENUMERATED_SUBSETS + 1;
+    }
+    return count;
+}
+
+std::vector<std::vector<int>> enumerate_subsets(const std::vector<int>& dimensions, int k){
+    std::vector<std::vector<int>> subsets;
+    std::vector<int> positions(k);
+    for (int i = 0; i < k; ++i) positions[i] = i;
+    int n = dimensions.size();
+    while (true){
+        std::vector<int> subset(k);
+        for (int i = 0; i < k; ++i) subset[i] = dimensions[positions[i]];
+        subsets.push_back(subset);
+        // advance to the next combination in lexicographic order
+        int i = k - 1;
+        while (i >= 0 && positions[i] == n - k + i) --i;
+        if (i < 0) break;
+        positions[i]++;
+        for (int j = i + 1; j < k; ++j) positions[j] = positions[j-1] + 1;
+    }
+    return subsets;
+}
+
+std::vector<int> sample_dimensions(const std::vector<int>& final_dimensions, int d_hat_2, std::mt19937& generator, std::uniform_int_distribution<int>& distribution){
     //randomly select d_hat dimensions
     std::set<int> selected_dimensions;
     while (selected_dimensions.size()<d_hat_2){
         //use the generator to generate a random number
         int index = distribution(generator);
-        selected_dimensions.insert(*next(set_final_dimensions.begin(), index));
+        selected_dimensions.insert(final_dimensions[index]);
     }
     return std::vector<int>(selected_dimensions.begin(), selected_dimensions.end());
 }
 
+// draws dimension subsets that have not been tried before
+// small subset spaces are enumerated and shuffled once, large ones are sampled with rejection
+class subset_sampler {
+public:
+    subset_sampler(const std::set<int>& set_final_dimensions, int d_hat_2, std::mt19937& generator)
+        : dimensions(set_final_dimensions.begin(), set_final_dimensions.end()), d_hat_2(d_hat_2),
+          generator(generator), distribution(0, set_final_dimensions.size()-1), next_subset(0){
+        enumerated = count_subsets(dimensions.size(), d_hat_2) <= MAX_ENUMERATED_SUBSETS;
+        if (enumerated){
+            subsets = enumerate_subsets(dimensions, d_hat_2);
+            std::shuffle(subsets.begin(), subsets.end(), generator);
+        }
+    }
+
+    // returns false once every subset has been drawn
+    bool next(std::vector<int>& subset){
+        if (enumerated){
+            if (next_subset >= subsets.size()) return false;
+            subset = subsets[next_subset++];
+            return true;
+        }
+        for (int attempt = 0; attempt < MAX_SAMPLING_ATTEMPTS; ++attempt){
+            subset = sample_dimensions(dimensions, d_hat_2, generator, distribution);
+            if (drawn.insert(subset).second) return true;
+        }
+        // the space is large but mostly drawn, accept a repeat; its Sphere result adds no point, so the round
+        // counts as stalled
+        return true;
+    }
+
+private:
+    std::vector<int> dimensions;
+    int d_hat_2;
+    std::mt19937& generator;
+    std::uniform_int_distribution<int> distribution;
+    bool enumerated;
+    std::vector<std::vector<int>> subsets;
+    size_t next_subset;
+    std::set<std::vector<int>> drawn;
+};
+
 point_set_t* project_points(point_set_t* skyline, const std::vector<int>& dimension_indices){
     // construct a new subset S_hat based on S with d_hat_2 dimension
     point_set_t* S_hat = alloc_point_set(skyline->numberOfPoints);
@@ -27,22 +106,11 @@ point_set_t* project_points(point_set_t* skyline, const std::vector<int>& dimens
             S_hat->points[j]->coord[p] = skyline->points[j]->coord[dimension_indices[p]];
         }
     }
+    metric_add(METRIC_PROJECTIONS);
+    metric_add(METRIC_PROJECTED_POINTS, skyline->numberOfPoints);
     return S_hat;
 }
 
-std::set<int> collect_output_ids(point_set_t* S_output){
-    std::set<int> point_ids;
-    if (S_output){
-        for (int j=0; j<S_output->numberOfPoints; ++j){
-            if (S_output->points[j]==nullptr){
-                printf("S_output point %d: nullptr\n", j+1);
-            }
-            point_ids.insert(S_output->points[j]->id);
-        }
-    }
-    return point_ids;
-}
-
 std::set<int> collect_ids(point_set_t* points){
     std::set<int> point_ids;
     for (int j=0; j<points->numberOfPoints; ++j){
@@ -108,47 +176,65 @@ point_set_t* fill_output_to_k(point_set_t* skyline, point_set_t* S_output, int K
     return build_output_from_ids(skyline, point_ids, true);
 }
 
+// run Sphere on the projection of skyline onto dimension_indices and return the ids of the selected points
+std::vector<int> sphere_on_subset(point_set_t* skyline, const std::vector<int>& dimension_indices, int k){
+    // only the ids of the Sphere solution are kept
+    point_arena_scope scope;
+    point_set_t* S_hat = project_points(skyline, dimension_indices);
+    // take the skyline of the newly constructed dataset S_hat
+    point_set_t* skyline_S_hat = skyline_point(S_hat);
+    // Sphere
+    point_set_t* S = sphereWSImpLP(skyline_S_hat, k);
+    std::set<int> set_S = collect_ids(S);
+    release_point_set(S, false);
+    release_point_set(skyline_S_hat, false);
+    release_point_set(S_hat, true);
+    return std::vector<int>(set_S.begin(), set_S.end());
+}
+
 } // namespace
 
-point_set_t* attribute_subset(point_set_t* skyline, point_set_t* S_output, int final_d, int d_hat_2, int K, std::set<int> set_final_dimensions){
+point_set_t* attribute_subset(point_set_t* skyline, point_set_t* S_output, int final_d, int d_hat_2, int K, std::set<int> set_final_dimensions, std::mt19937& generator){
     if (final_d < d_hat_2){
         // error: final_d < d_hat_2
         printf("error: final_d < d_hat_2\n");
         exit(1);
     }
-    std::mt19937& generator = experiment_random_generator();
-    std::uniform_int_distribution<int> distribution(0, final_d-1);
+    subset_sampler sampler(set_final_dimensions, d_hat_2, generator);
     int k = d_hat_2 + 1;
     int num_rounds = 0;
+    int stalled_rounds = 0;
 
-    while (S_output == nullptr || S_output->numberOfPoints < K){
+    // the union of the Sphere results over all rounds
+    std::set<int> set_union;
+    if (S_output){
+        set_union = collect_ids(S_output);
+        release_point_set(S_output, false);
+        S_output = nullptr;
+    }
+    while (set_union.size() < K && !cancellation_requested()){
         num_rounds++;
-        if (num_rounds > 50){
-            // exit if the number of rounds exceeds 30
-            // printf("rounds exceeded 30, exiting...\n");
+        if (num_rounds > MAX_ROUNDS){
+            // exit if the number of rounds exceeds MAX_ROUNDS
             break;
         }
-        std::vector<int> dimension_indices = sample_dimensions(set_final_dimensions, final_d, d_hat_2, generator, distribution);
-        point_set_t* S_hat = project_points(skyline, dimension_indices);
-        // take the skyline of the newly constructed dataset S_hat
-        point_set_t* skyline_S_hat = skyline_point(S_hat);
-        // Sphere
-        point_set_t* S = sphereWSImpLP(skyline_S_hat, k);
+        std::vector<int> dimension_indices;
+        if (!sampler.next(dimension_indices)){
+            // every dimension subset has been tried
+            break;
+        }
+        std::vector<int> S = sphere_on_subset(skyline, dimension_indices, k);
         // take the union of S_output and S
-        // record the current set of id of S_output
-        std::set<int> set_S_output = collect_output_ids(S_output);
-        std::set<int> set_S = collect_ids(S);
-        std::set<int> set_union;
-        std::set_union(set_S_output.begin(), set_S_output.end(), set_S.begin(), set_S.end(), std::inserter(set_union, set_union.begin()));
-        if (S_output){
-            release_point_set(S_output, false);
+        size_t union_size = set_union.size();
+        set_union.insert(S.begin(), S.end());
+        // stop early once recent rounds no longer grow the union
+        stalled_rounds = set_union.size() > union_size ? 0 : stalled_rounds + 1;
+        if (stalled_rounds >= MAX_STALLED_ROUNDS){
+            break;
         }
-        S_output = build_output_from_ids(skyline, set_union, false);
-        release_point_set(S, false);
-        release_point_set(skyline_S_hat, false);
-        release_point_set(S_hat, true);
     }
     printf("number of rounds: %d\n", num_rounds);
+    S_output = build_output_from_ids(skyline, set_union, false);
     if (S_output->numberOfPoints > K){
         S_output = truncate_output(S_output, K);
     }
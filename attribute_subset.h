@@ -7,4 +7,5 @@
 #include <vector>
 #include "other/data_struct.h"
 
-point_set_t* attribute_subset(point_set_t* skyline, point_set_t* S_output, int final_d, int d_hat_2, int K, std::set<int> set_final_dimensions);
\ No newline at end of file
+// the dimension subsets are drawn from generator
+point_set_t* attribute_subset(point_set_t* skyline, point_set_t* S_output, int final_d, int d_hat_2, int K, std::set<int> set_final_dimensions, std::mt19937& generator);
\ No newline at end of file
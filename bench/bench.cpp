@@ -0,0 +1,437 @@
+// microbenchmarks of the core kernels over generated datasets
+// every case is set up outside the timed region; the results are written as one JSON document
+#include "../highdim.h"
+#include "../other/pruning.h"
+#include "../other/frame.h"
+#include "../other/batch_argmax.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// a generated dataset and the inputs derived from it, built lazily for the kernels that need them
+struct bench_case{
+    std::string distribution;
+    int n;
+    int d;
+    int k;
+    int rounds;
+    std::mt19937 generator;
+    point_set_t* P = nullptr;
+    point_set_t* skyline = nullptr;
+    point_t* u = nullptr;
+    std::vector<point_t*> ext_vec;
+    double mrr = -1;    // evaluateLP of case_subset, once computed
+    std::vector<std::pair<std::string, double> > values;    // what the last run reports besides its time
+};
+
+struct bench_kernel{
+    const char* name;
+    int max_n;  // default limits of the kernels that are infeasible beyond them
+    int max_d;
+    std::function<double(bench_case&)> run;
+};
+
+struct bench_options{
+    std::vector<std::string> distributions = {"uniform", "correlated", "anticorrelated"};
+    std::vector<int> n = {1000, 10000};
+    std::vector<int> d = {2, 5, 10};
+    std::vector<std::string> kernels;
+    int reps = 5;
+    int k = 10;
+    int rounds = 5;
+    unsigned int seed = 1;
+    bool no_limits = false;
+    std::string output = "output/bench.json";
+};
+
+double clamp_unit(double value){
+    return std::min(1.0, std::max(1e-6, value));
+}
+
+// uniform: independent coordinates; correlated: close to the diagonal; anticorrelated: close to the
+// hyperplane through the center orthogonal to the diagonal (the usual skyline benchmark families)
+point_set_t* generate_points(const std::string& distribution, int n, int d, std::mt19937& generator){
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> center(0.5, 0.15);
+    std::normal_distribution<double> spread(0.0, 0.05);
+    point_set_t* P = alloc_point_set(n);
+    for (int i = 0; i < n; ++i){
+        point_t* p = alloc_point(d, i);
+        if (distribution == "correlated"){
+            double base = center(generator);
+            for (int j = 0; j < d; ++j) p->coord[j] = clamp_unit(base + spread(generator));
+        }
+        else if (distribution == "anticorrelated"){
+            double base = 0.5 + spread(generator);
+            double mean = 0;
+            for (int j = 0; j < d; ++j){
+                p->coord[j] = uniform(generator) - 0.5;
+                mean += p->coord[j] / d;
+            }
+            for (int j = 0; j < d; ++j) p->coord[j] = clamp_unit(base + p->coord[j] - mean);
+        }
+        else {
+            for (int j = 0; j < d; ++j) p->coord[j] = clamp_unit(uniform(generator));
+        }
+        P->points[i] = p;
+    }
+    return P;
+}
+
+point_set_t* case_skyline(bench_case& c){
+    if (c.skyline == nullptr) c.skyline = skyline_point(c.P);
+    return c.skyline;
+}
+
+point_t* case_utility(bench_case& c){
+    if (c.u == nullptr){
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        c.u = alloc_point(c.d);
+        double sum = 0;
+        for (int j = 0; j < c.d; ++j) sum += c.u->coord[j] = uniform(c.generator);
+        for (int j = 0; j < c.d; ++j) c.u->coord[j] /= sum;
+    }
+    return c.u;
+}
+
+// the extreme vectors after some pairwise questions answered by the utility of the case,
+// as maintained by the interactive algorithm
+std::vector<point_t*>& case_extreme_vectors(bench_case& c){
+    if (!c.ext_vec.empty()) return c.ext_vec;
+    for (int i = 0; i < c.d; ++i){
+        point_t* e = alloc_point(c.d);
+        for (int j = 0; j < c.d; ++j) e->coord[j] = i == j ? -1 : 0;
+        c.ext_vec.push_back(e);
+    }
+    point_set_t* skyline = case_skyline(c);
+    point_t* u = case_utility(c);
+    std::uniform_int_distribution<int> pick(0, skyline->numberOfPoints - 1);
+    for (int r = 0; r < c.rounds && skyline->numberOfPoints > 1; ++r){
+        point_t* a = skyline->points[pick(c.generator)];
+        point_t* b = skyline->points[pick(c.generator)];
+        if (a == b) continue;
+        if (dot_prod(u, a) < dot_prod(u, b)) std::swap(a, b);
+        point_t* tmp = sub(b, a);
+        c.ext_vec.push_back(scale(1 / calc_len(tmp), tmp));
+        release_point(tmp);
+    }
+    return c.ext_vec;
+}
+
+// get_extreme_pts replaces the extreme vectors it is given, so every run works on its own copy
+std::vector<point_t*> copy_vectors(const std::vector<point_t*>& vectors){
+    std::vector<point_t*> copies;
+    for (auto v : vectors) copies.push_back(copy(v));
+    return copies;
+}
+
+void release_vectors(std::vector<point_t*>& vectors){
+    for (auto v : vectors) release_point(v);
+    vectors.clear();
+}
+
+// the first k skyline points, a stand-in for an output set
+point_set_t* case_subset(bench_case& c){
+    point_set_t* skyline = case_skyline(c);
+    int size = std::min(c.k, skyline->numberOfPoints);
+    point_set_t* S = alloc_point_set(size);
+    for (int i = 0; i < size; ++i) S->points[i] = skyline->points[i];
+    return S;
+}
+
+// the exact MRR of case_subset, which the MRR estimates and tests are compared with
+double case_mrr(bench_case& c){
+    if (c.mrr >= 0) return c.mrr;
+    point_set_t* S = case_subset(c);
+    c.mrr = evaluateLP(c.skyline, S, 0);
+    release_point_set(S, false);
+    return c.mrr;
+}
+
+void release_case(bench_case& c){
+    release_vectors(c.ext_vec);
+    if (c.u != nullptr) release_point(c.u);
+    if (c.skyline != nullptr) release_point_set(c.skyline, false);
+    release_point_set(c.P, true);
+}
+
+template <typename F>
+double time_call(F f){
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double bench_pruning(bench_case& c, bool rtree, int dom_option = HYPER_PLANE){
+    point_set_t* skyline = case_skyline(c);
+    std::vector<point_t*> ext_vec = copy_vectors(case_extreme_vectors(c));
+    std::vector<int> C_idx;
+    for (int i = 0; i < skyline->numberOfPoints; ++i) C_idx.push_back(i);
+    double rr;
+    double seconds = time_call([&](){
+        if (rtree) rtree_pruning(skyline, C_idx, ext_vec, rr, EXACT_BOUND, dom_option);
+        else sql_pruning(skyline, C_idx, ext_vec, rr, EXACT_BOUND, dom_option);
+    });
+    release_vectors(ext_vec);
+    return seconds;
+}
+
+// mrr_at_most on case_subset for the threshold offset from its exact MRR: false below it, true above it
+double bench_mrr_at_most(bench_case& c, double offset){
+    double eps = case_mrr(c) + offset;
+    point_set_t* S = case_subset(c);
+    bool answer;
+    int lp_count;
+    double seconds = time_call([&](){ answer = mrr_at_most(c.skyline, S, eps, &lp_count); });
+    release_point_set(S, false);
+    c.values = {{"eps", eps}, {"answer", answer}, {"lp_count", lp_count}, {"mrr", c.mrr}};
+    return seconds;
+}
+
+const int UNLIMITED = 1 << 30;
+
+// qhull based kernels are only feasible in low dimensions, DMM discretizes 4^(d-1) directions
+std::vector<bench_kernel> bench_kernels(){
+    return {
+        {"skyline_point", UNLIMITED, UNLIMITED, [](bench_case& c){
+            point_set_t* skyline = nullptr;
+            double seconds = time_call([&](){ skyline = skyline_point(c.P); });
+            release_point_set(skyline, false);
+            return seconds;
+        }},
+        {"worstDirection", UNLIMITED, UNLIMITED, [](bench_case& c){
+            point_set_t* S = case_subset(c);
+            point_t* pt = c.skyline->points[c.skyline->numberOfPoints - 1];
+            double* v = new double[c.d];
+            double seconds = time_call([&](){ worstDirection(S, pt, v); });
+            delete[] v;
+            release_point_set(S, false);
+            return seconds;
+        }},
+        {"evaluateLP", 100000, UNLIMITED, [](bench_case& c){
+            point_set_t* S = case_subset(c);
+            double seconds = time_call([&](){ evaluateLP(c.skyline, S, 0); });
+            release_point_set(S, false);
+            return seconds;
+        }},
+        {"mrr_at_most_below", 100000, UNLIMITED, [](bench_case& c){ return bench_mrr_at_most(c, -0.01); }},
+        {"mrr_at_most_above", 100000, UNLIMITED, [](bench_case& c){ return bench_mrr_at_most(c, 0.01); }},
+        {"estimate_mrr", 100000, UNLIMITED, [](bench_case& c){
+            point_set_t* S = case_subset(c);
+            mrr_estimate estimate;
+            double seconds = time_call([&](){ estimate = estimate_mrr(c.skyline, S, 0); });
+            release_point_set(S, false);
+            c.values = {{"estimate", estimate.mrr}, {"mass", estimate.mass}, {"samples", estimate.samples},
+                {"mrr", case_mrr(c)}};
+            return seconds;
+        }},
+        {"batch_argmax", UNLIMITED, UNLIMITED, [](bench_case& c){
+            // as many directions as evaluateLP finds the best points of at once
+            const int m = 1024;
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            std::vector<double> directions((size_t)m * c.d);
+            for (double& x : directions) x = uniform(c.generator);
+            std::vector<double> max(m);
+            std::vector<int> argmax(m);
+            return time_call([&](){ batch_argmax(c.skyline, &directions[0], m, &max[0], &argmax[0]); });
+        }},
+        {"get_extreme_pts", UNLIMITED, 8, [](bench_case& c){
+            std::vector<point_t*> ext_vec = copy_vectors(case_extreme_vectors(c));
+            std::vector<point_t*> ext_pts;
+            double seconds = time_call([&](){ ext_pts = get_extreme_pts(ext_vec); });
+            release_vectors(ext_pts);
+            release_vectors(ext_vec);
+            return seconds;
+        }},
+        {"sql_pruning", 100000, 8, [](bench_case& c){ return bench_pruning(c, false); }},
+        {"rtree_pruning", 100000, 8, [](bench_case& c){ return bench_pruning(c, true); }},
+        // HALFSPACE never computes the extreme points of R, so it is not bound to the dimensions of qhull, but it solves
+        // LPs for every point that is not pruned: n = 10000, d = 50 takes a minute
+        {"rtree_pruning_halfspace", 10000, 100, [](bench_case& c){ return bench_pruning(c, true, HALFSPACE); }},
+        {"contructRtree", UNLIMITED, UNLIMITED, [](bench_case& c){
+            point_set_t* skyline = case_skyline(c);
+            std::vector<int> C_idx;
+            for (int i = 0; i < skyline->numberOfPoints; ++i) C_idx.push_back(i);
+            rtree_info* aInfo = (rtree_info*)malloc(sizeof(rtree_info));
+            memset(aInfo, 0, sizeof(rtree_info));
+            aInfo->m = 18;
+            aInfo->M = 36;
+            aInfo->dim = c.d;
+            aInfo->reinsert_p = 27;
+            aInfo->no_histogram = C_idx.size();
+            // the tree is not released, as in rtree_pruning
+            double seconds = time_call([&](){ contructRtree(skyline, C_idx, aInfo); });
+            free(aInfo);
+            return seconds;
+        }},
+        {"sphereWSImpLP", 100000, 100, [](bench_case& c){
+            point_set_t* S = nullptr;
+            // Sphere starts from the d boundary points, so it needs k >= d
+            double seconds = time_call([&](){ S = sphereWSImpLP(case_skyline(c), std::max(c.k, c.d)); });
+            release_point_set(S, false);
+            return seconds;
+        }},
+        {"DMM", 100000, 8, [](bench_case& c){
+            point_set_t* S = nullptr;
+            double seconds = time_call([&](){ S = DMM(case_skyline(c), c.k); });
+            release_point_set(S, false);
+            return seconds;
+        }},
+        {"geoGreedy", UNLIMITED, 8, [](bench_case& c){
+            point_set_t* S = nullptr;
+            // GeoGreedy starts from the d boundary points, so it needs k >= d
+            double seconds = time_call([&](){ S = geoGreedy(std::max(c.k, c.d), case_skyline(c)); });
+            release_point_set(S, false);
+            return seconds;
+        }},
+        {"frameConeFastLP", UNLIMITED, 100, [](bench_case& c){
+            std::vector<point_t*>& ext_vec = case_extreme_vectors(c);
+            std::vector<int> idxs;
+            return time_call([&](){ frameConeFastLP(ext_vec, idxs); });
+        }},
+        {"ask_projected_question", UNLIMITED, UNLIMITED, [](bench_case& c){
+            std::vector<int> dimensions;
+            for (int j = 0; j < std::min(c.d, 5); ++j) dimensions.push_back(j);
+            question_mapping qm;
+            point_t* u = case_utility(c);
+            return time_call([&](){ ask_projected_question(c.skyline, u, dimensions, 2, qm); });
+        }},
+    };
+}
+
+bool needs_skyline(const std::string& kernel){
+    return kernel != "skyline_point";
+}
+
+std::vector<std::string> split_list(const std::string& text){
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+std::vector<int> split_ints(const std::string& text){
+    std::vector<int> values;
+    for (auto& item : split_list(text)) values.push_back(std::stoi(item));
+    return values;
+}
+
+void print_usage(){
+    fprintf(stderr,
+        "usage: ./run_bench [--distribution uniform,correlated,anticorrelated] [--n 1000,10000] [--d 2,5,10]\n"
+        "                   [--kernel name,...] [--reps 5] [--k 10] [--rounds 5] [--seed 1] [--no-limits]\n"
+        "                   [--output output/bench.json]\n");
+}
+
+bool parse_options(int argc, char* argv[], bench_options& options){
+    for (int i = 1; i < argc; ++i){
+        std::string option = argv[i];
+        if (option == "--no-limits"){
+            options.no_limits = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (option == "--distribution") options.distributions = split_list(value);
+        else if (option == "--n") options.n = split_ints(value);
+        else if (option == "--d") options.d = split_ints(value);
+        else if (option == "--kernel") options.kernels = split_list(value);
+        else if (option == "--reps") options.reps = std::stoi(value);
+        else if (option == "--k") options.k = std::stoi(value);
+        else if (option == "--rounds") options.rounds = std::stoi(value);
+        else if (option == "--seed") options.seed = std::stoul(value);
+        else if (option == "--output") options.output = value;
+        else return false;
+    }
+    return options.reps > 0 && options.k > 0;
+}
+
+void write_result(std::ostream& out, const bench_kernel& kernel, const bench_case& c, const std::vector<double>& times){
+    double mean = 0;
+    for (double t : times) mean += t / times.size();
+    double variance = 0;
+    for (double t : times) variance += (t - mean) * (t - mean);
+    variance = times.size() > 1 ? variance / (times.size() - 1) : 0;
+    out << "{\"kernel\":\"" << kernel.name << "\",\"distribution\":\"" << c.distribution
+        << "\",\"n\":" << c.n << ",\"d\":" << c.d << ",\"k\":" << c.k << ",\"status\":\"ok\"";
+    if (c.skyline != nullptr) out << ",\"skyline_size\":" << c.skyline->numberOfPoints;
+    out << ",\"reps\":" << times.size() << std::setprecision(9)
+        << ",\"mean_seconds\":" << mean << ",\"variance\":" << variance
+        << ",\"stddev_seconds\":" << std::sqrt(variance)
+        << ",\"min_seconds\":" << *std::min_element(times.begin(), times.end())
+        << ",\"max_seconds\":" << *std::max_element(times.begin(), times.end())
+        << ",\"times_seconds\":[";
+    for (size_t i = 0; i < times.size(); ++i) out << (i > 0 ? "," : "") << times[i];
+    out << "]";
+    for (auto& value : c.values) out << ",\"" << value.first << "\":" << value.second;
+    out << "}";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]){
+    bench_options options;
+    if (!parse_options(argc, argv, options)){
+        print_usage();
+        return 2;
+    }
+    std::vector<bench_kernel> kernels;
+    for (auto& kernel : bench_kernels()){
+        if (options.kernels.empty() || std::find(options.kernels.begin(), options.kernels.end(), kernel.name) != options.kernels.end())
+            kernels.push_back(kernel);
+    }
+    // the qhull based kernels exchange data with qhull through files in output/
+    std::filesystem::create_directories("output");
+
+    std::ostringstream results;
+    bool first = true;
+    for (auto& distribution : options.distributions){
+        for (int n : options.n){
+            for (int d : options.d){
+                bench_case c;
+                c.distribution = distribution;
+                c.n = n;
+                c.d = d;
+                c.k = options.k;
+                c.rounds = options.rounds;
+                c.generator.seed(options.seed);
+                seed_thread_rand(options.seed);
+                c.P = generate_points(distribution, n, d, c.generator);
+                for (auto& kernel : kernels){
+                    results << (first ? "\n  " : ",\n  ");
+                    first = false;
+                    if (!options.no_limits && (n > kernel.max_n || d > kernel.max_d)){
+                        results << "{\"kernel\":\"" << kernel.name << "\",\"distribution\":\"" << distribution
+                            << "\",\"n\":" << n << ",\"d\":" << d << ",\"status\":\"skipped\",\"reason\":\"beyond_default_limits\"}";
+                        continue;
+                    }
+                    fprintf(stderr, "%s %s n=%d d=%d\n", kernel.name, distribution.c_str(), n, d);
+                    if (needs_skyline(kernel.name)) case_skyline(c);
+                    std::vector<double> times;
+                    c.values.clear();
+                    for (int r = 0; r < options.reps; ++r) times.push_back(kernel.run(c));
+                    write_result(results, kernel, c, times);
+                }
+                release_case(c);
+            }
+        }
+    }
+
+    std::ofstream output(options.output);
+    output << "{\"seed\":" << options.seed << ",\"reps\":" << options.reps
+        << ",\"results\":[" << results.str() << "\n]}\n";
+    fprintf(stderr, "results: %s\n", options.output.c_str());
+    return output ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+#include "experiment.h"
+#include "experiment_random.h"
+#include "highdim.h"
+#include "json_lines.h"
+#include "other/hull_vertices.h"
+#include "other/kernel_threads.h"
+#include "other/metrics.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+point_set_t* construct_sphere_dataset(point_set_t* skyline, const std::set<int>& final_dimensions){
+    point_set_t* D_test = alloc_point_set(skyline->numberOfPoints);
+    for (int i = 0; i < skyline->numberOfPoints; i++) {
+        D_test->points[i] = alloc_point(final_dimensions.size());
+        // Set the ID to be the array index so we can map back correctly
+        D_test->points[i]->id = i;
+        int j = 0;
+        for (auto dim : final_dimensions) {
+            D_test->points[i]->coord[j++] = skyline->points[i]->coord[dim];
+        }
+    }
+    return D_test;
+}
+
+point_set_t* copy_sphere_result_to_original(point_set_t* skyline, point_set_t* skyline_D_test, point_set_t* S_test){
+    point_set_t* S_test_original = alloc_point_set(S_test->numberOfPoints);
+    int valid_index = 0;
+    for (int i = 0; i < S_test->numberOfPoints; i++){
+        int target_id = S_test->points[i]->id;
+
+        // Find the point in skyline_D_test with this ID
+        int skyline_index = -1;
+        for (int j = 0; j < skyline_D_test->numberOfPoints; j++) {
+            if (skyline_D_test->points[j]->id == target_id) {
+                skyline_index = j;
+                break;
+            }
+        }
+
+        if (skyline_index == -1) {
+            continue;
+        }
+
+        // Get the corresponding point from D_test (which has the array index)
+        point_t* D_test_point = skyline_D_test->points[skyline_index];
+        int original_skyline_index = D_test_point->id;
+
+        if (original_skyline_index < 0 || original_skyline_index >= skyline->numberOfPoints) {
+            continue;
+        }
+
+        // Create a new point with original dimensions
+        point_t* original_point = skyline->points[original_skyline_index];
+        if (original_point == NULL) {
+            continue;
+        }
+
+        point_t* new_point = alloc_point(original_point->dim);
+        new_point->id = original_point->id;
+        for (int j = 0; j < original_point->dim; j++) {
+            new_point->coord[j] = original_point->coord[j];
+        }
+        S_test_original->points[valid_index++] = new_point;
+    }
+    return S_test_original;
+}
+
+void format_experiment_result(std::ostringstream& out, const char* method, double regret_ratio, double time_seconds,
+        int output_size, int questions, const std::string& metrics, const std::string& trial_id){
+    out << "EXPERIMENT_RESULT {\"method\":\"" << method
+        << "\",\"status\":\"ok\",\"regret_ratio\":" << std::setprecision(17) << regret_ratio
+        << ",\"time_seconds\":" << time_seconds
+        << ",\"output_size\":" << output_size
+        << ",\"questions\":" << questions;
+    if (!metrics.empty()) out << ",\"metrics\":" << metrics;
+    if (!trial_id.empty()) out << ",\"trial\":\"" << trial_id << "\"";
+    out << "}\n";
+}
+
+void format_unavailable_experiment_result(std::ostringstream& out, const char* method, const char* status,
+        const char* reason, const std::string& trial_id){
+    out << "EXPERIMENT_RESULT {\"method\":\"" << method
+        << "\",\"status\":\"" << status << "\",\"reason\":\"" << reason << "\"";
+    if (!trial_id.empty()) out << ",\"trial\":\"" << trial_id << "\"";
+    out << "}\n";
+}
+
+// one line of a batch manifest
+struct batch_trial{
+    std::string id;
+    std::string utility_file;
+    unsigned int seed;
+    experiment_parameters parameters;
+};
+
+bool read_batch_manifest(const char* manifest, std::vector<batch_trial>& trials){
+    std::ifstream input(manifest);
+    if (!input) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        batch_trial trial;
+        int skip_sphere;
+        if (!(fields >> trial.id >> trial.utility_file >> trial.seed >> trial.parameters.d_prime
+                >> trial.parameters.d_hat >> trial.parameters.d_hat_2 >> trial.parameters.K
+                >> trial.parameters.num_questions >> skip_sphere)) {
+            std::cerr << "Error: invalid manifest line: " << line << "\n";
+            return false;
+        }
+        trial.parameters.skip_sphere = skip_sphere != 0;
+        // the fixed fields may be followed by options as key=value
+        trial.parameters.cmp_option = RANDOM;
+        trial.parameters.dom_option = HYPER_PLANE;
+        std::string option;
+        while (fields >> option) {
+            size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            bool valid = key == "cmp" ? parse_cmp_option(value, trial.parameters.cmp_option)
+                : key == "dom" && parse_dom_option(value, trial.parameters.dom_option);
+            if (!valid) {
+                std::cerr << "Error: invalid manifest option " << option << " in line: " << line << "\n";
+                return false;
+            }
+        }
+        // the id goes into the JSON records as is
+        trial.id = json_escape(trial.id);
+        trials.push_back(trial);
+    }
+    return true;
+}
+
+// normalize the points P read for a dataset and take them, or their hull vertices, as the skyline
+point_set_t* prepare_points(point_set_t* P, point_set_t** dataset, bool hull){
+    linear_normalize(P);
+    *dataset = P;
+    if (hull && P->numberOfPoints > 0) return hull_vertices(P);
+    point_set_t* skyline = alloc_point_set(P->numberOfPoints);
+    for (int i = 0; i < P->numberOfPoints; ++i) skyline->points[i] = P->points[i];
+    return skyline;
+}
+
+} // namespace
+
+bool parse_cmp_option(const std::string& name, int& option){
+    if (name == "random") option = RANDOM;
+    else if (name == "simplex") option = SIMPLEX;
+    else return false;
+    return true;
+}
+
+bool parse_dom_option(const std::string& name, int& option){
+    if (name == "hyperplane") option = HYPER_PLANE;
+    else if (name == "conical_hull") option = CONICAL_HULL;
+    else if (name == "halfspace") option = HALFSPACE;
+    else return false;
+    return true;
+}
+
+point_t* read_experiment_utility(const std::string& path, int dimension){
+    std::ifstream input(path);
+    point_t* utility = alloc_point(dimension);
+    for (int i = 0; i < dimension; ++i) {
+        if (!(input >> utility->coord[i])) {
+            release_point(utility);
+            return nullptr;
+        }
+    }
+    return utility;
+}
+
+experiment_outcome run_experiment_trial(point_set_t* skyline, point_t* u, const experiment_parameters& parameters,
+                                        double max_utility){
+    int size = 2; // question size
+    int d_bar = 5;
+    int num_questions = parameters.num_questions;
+    // below are default parameters from the interactive paper
+    //-------------------------------------
+    int s = 3; //question size in interactive algorithm (3 as default)
+    double epsilon = 0.0;
+    int maxRound = 1000;
+    double Qcount = 0, Csize = 0;
+    int prune_option = RTREE;
+    int dom_option = parameters.dom_option;
+    int stop_option = EXACT_BOUND;
+    int cmp_option = parameters.cmp_option;
+    //-------------------------------------
+
+    reset_metrics();
+    highdim_output* h = interactive_highdim(skyline, size, d_bar, parameters.d_hat, parameters.d_hat_2, u, parameters.K, s, epsilon, maxRound, Qcount, Csize, cmp_option, stop_option, prune_option, dom_option, num_questions);
+    point_set_t* S = h->S;
+
+    experiment_outcome outcome;
+    outcome.metrics = format_metrics(snapshot_metrics());
+    outcome.cancelled = cancellation_requested();
+    outcome.error = h->error;
+    if (outcome.error != nullptr) {
+        release_point_set(h->S, false);
+        delete h;
+        return outcome;
+    }
+    // for comparison, evaluate the performance of Sphere. the return size is either
+    // (# questions asked in interactive algorithm) * s (Phase 3A) or K (Phase 3B)
+    outcome.phase_3a = S->numberOfPoints == 1;
+    int K_sphere = outcome.phase_3a ? Qcount * s : parameters.K;
+
+    outcome.regret_ratio = max_utility > 0 ? evaluateLP(S, 0, u, max_utility) : evaluateLP(skyline, S, 0, u);
+    outcome.time_seconds = h->time_12 + h->time_3;
+    outcome.output_size = S->numberOfPoints;
+    outcome.questions = parameters.num_questions - num_questions;
+
+    outcome.sphere_available = false;
+    outcome.sphere_reason = parameters.skip_sphere ? "skipped_by_experiment_policy" : "candidate_dimension_count_exceeds_output_size";
+    if (outcome.cancelled && !parameters.skip_sphere) outcome.sphere_reason = "cancelled";
+    // for comparison, test the mrr returned by the Sphere algorithm on the dataset with the final dimensions
+    if (!outcome.cancelled && !parameters.skip_sphere && h->final_dimensions.size() <= K_sphere){
+        point_set_t* D_test = construct_sphere_dataset(skyline, h->final_dimensions);
+        reset_metrics();
+        // record the time in seconds
+        auto start_time_sphere = std::chrono::high_resolution_clock::now();
+        point_set_t* skyline_D_test = skyline_point(D_test);
+        point_set_t* S_test = sphereWSImpLP(skyline_D_test, K_sphere);
+        auto end_time_sphere = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration_sphere = end_time_sphere - start_time_sphere;
+        outcome.sphere_metrics = format_metrics(snapshot_metrics());
+
+        point_set_t* S_test_original = copy_sphere_result_to_original(skyline, skyline_D_test, S_test);
+        outcome.sphere_available = true;
+        outcome.sphere_reason = "";
+        outcome.sphere_regret_ratio = max_utility > 0 ? evaluateLP(S_test_original, 0, u, max_utility)
+                                                       : evaluateLP(skyline, S_test_original, 0, u);
+        outcome.sphere_time_seconds = h->time_12 + duration_sphere.count();
+        outcome.sphere_output_size = S_test->numberOfPoints;
+        // the deadline may also pass while Sphere-Adapt runs, leaving it with a partial solution
+        if (cancellation_requested()) {
+            outcome.sphere_available = false;
+            outcome.sphere_reason = "cancelled";
+        }
+
+        release_point_set(skyline_D_test, false);
+        release_point_set(S_test, false); // Don't clear since points are references
+        release_point_set(S_test_original, true);
+        release_point_set(D_test, true);
+    }
+
+    release_point_set(h->S, false);
+    delete h;
+    return outcome;
+}
+
+std::string format_experiment_records(const experiment_outcome& outcome, const std::string& trial_id){
+    std::ostringstream out;
+    if (outcome.cancelled) {
+        format_unavailable_experiment_result(out, "FHDR", "timeout", "deadline_exceeded", trial_id);
+        format_unavailable_experiment_result(out, "Sphere-Adapt", "unavailable", outcome.sphere_reason, trial_id);
+        return out.str();
+    }
+    if (outcome.error != nullptr) {
+        format_unavailable_experiment_result(out, "FHDR", "error", outcome.error, trial_id);
+        return out.str();
+    }
+    format_experiment_result(out, "FHDR", outcome.regret_ratio, outcome.time_seconds,
+        outcome.output_size, outcome.questions, outcome.metrics, trial_id);
+    if (outcome.sphere_available) {
+        format_experiment_result(out, "Sphere-Adapt", outcome.sphere_regret_ratio, outcome.sphere_time_seconds,
+            outcome.sphere_output_size, outcome.questions, outcome.sphere_metrics, trial_id);
+    }
+    else {
+        format_unavailable_experiment_result(out, "Sphere-Adapt", "unavailable", outcome.sphere_reason, trial_id);
+    }
+    return out.str();
+}
+
+std::string format_experiment_error(const char* status, const char* reason, const std::string& trial_id){
+    std::ostringstream out;
+    format_unavailable_experiment_result(out, "FHDR", status, reason, trial_id);
+    return out.str();
+}
+
+point_set_t* prepare_experiment_dataset(char* input, point_set_t** dataset, bool hull){
+    return prepare_points(read_points(input), dataset, hull);
+}
+
+point_set_t* load_experiment_dataset(const std::string& path, point_set_t** dataset, bool hull){
+    struct stat status;
+    if (path.size() >= MAX_FILENAME_LENG || stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) return nullptr;
+    point_set_t* P = try_read_points(path.c_str());
+    if (P == nullptr) return nullptr;
+    if (P->numberOfPoints == 0){
+        release_point_set(P, true);
+        return nullptr;
+    }
+    return prepare_points(P, dataset, hull);
+}
+
+void release_experiment_dataset(point_set_t* skyline, point_set_t* dataset){
+    release_point_set(skyline, false);
+    release_point_set(dataset, true);
+}
+
+int run_experiment_batch(char* input, const char* manifest, int num_threads, bool hull){
+    std::vector<batch_trial> trials;
+    if (!read_batch_manifest(manifest, trials)) {
+        std::cerr << "Error: cannot read batch manifest " << manifest << "\n";
+        return 2;
+    }
+
+    // load and normalize the dataset once for all trials
+    point_set_t* P;
+    point_set_t* skyline = prepare_experiment_dataset(input, &P, hull);
+    int d = P->points[0]->dim;
+    printf("number of skyline points: %d\n", skyline->numberOfPoints);
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > trials.size()) num_threads = trials.size();
+
+    // the utility vectors of all trials, and the largest utilities of the skyline for them in one pass
+    std::vector<point_t*> utilities(trials.size());
+    std::vector<point_t*> valid;
+    for (size_t t = 0; t < trials.size(); ++t){
+        utilities[t] = read_experiment_utility(trials[t].utility_file, d);
+        if (utilities[t] != nullptr) valid.push_back(utilities[t]);
+    }
+    point_set_t* U = alloc_point_set(valid.size());
+    std::copy(valid.begin(), valid.end(), U->points);
+    std::vector<double> best = max_utilities(skyline, U);
+    release_point_set(U, false);
+    std::vector<double> max_utility(trials.size(), 0);
+    for (size_t t = 0, j = 0; t < trials.size(); ++t){
+        if (utilities[t] != nullptr) max_utility[t] = best[j++];
+    }
+
+    // the skyline is shared read-only between the workers; every trial seeds the random source of its own thread
+    std::atomic<size_t> next_trial(0);
+    std::mutex output_mutex;
+    // the workers divide the cores for the parallel kernels of their trials
+    int kernel_budget = kernel_threads_per_worker(num_threads);
+    auto worker = [&](){
+        set_thread_kernel_threads(kernel_budget);
+        for (size_t t = next_trial++; t < trials.size(); t = next_trial++){
+            const batch_trial& trial = trials[t];
+            seed_experiment_random(trial.seed);
+            std::string records;
+            point_t* u = utilities[t];
+            if (u == nullptr) {
+                records = format_experiment_error("error", "invalid_utility_file", trial.id);
+            }
+            else {
+                experiment_outcome outcome = run_experiment_trial(skyline, u, trial.parameters, max_utility[t]);
+                records = format_experiment_records(outcome, trial.id);
+                release_point(u);
+            }
+            // emit the records of a trial in one piece so that concurrent trials do not interleave
+            std::lock_guard<std::mutex> lock(output_mutex);
+            fputs(records.c_str(), stdout);
+            fflush(stdout);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_threads; ++i) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+    set_thread_kernel_threads(0);
+
+    release_experiment_dataset(skyline, P);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef EXPERIMENT_H
+#define EXPERIMENT_H
+
+#include "other/data_struct.h"
+#include <string>
+
+// parameters of a single FHDR trial, in the order of the command line arguments
+struct experiment_parameters{
+    int d_prime;        // number of dimensions in the utility vector (d_int)
+    int d_hat;          // number of dimensions in the cover in phase 1 (m)
+    int d_hat_2;        // number of dimensions in the cover in phase 3 (w)
+    int K;              // return size of the attribute subset method
+    int num_questions;  // number of questions allowed (q)
+    bool skip_sphere;   // do not run the Sphere-Adapt baseline
+    int cmp_option;     // how the Phase 3 questions are picked: RANDOM or SIMPLEX
+    int dom_option;     // how Phase 3 prunes dominated points: HYPER_PLANE, CONICAL_HULL or HALFSPACE
+};
+
+// the cmp_option named "random" or "simplex", as in manifests and requests; false for another name
+bool parse_cmp_option(const std::string& name, int& option);
+// the dom_option named "hyperplane", "conical_hull" or "halfspace"; false for another name
+bool parse_dom_option(const std::string& name, int& option);
+
+// the measurements of a single trial, for FHDR and the Sphere-Adapt baseline
+struct experiment_outcome{
+    bool phase_3a;
+    double regret_ratio;
+    double time_seconds;
+    int output_size;
+    int questions;
+    bool sphere_available;
+    const char* sphere_reason;
+    double sphere_regret_ratio;
+    double sphere_time_seconds;
+    int sphere_output_size;
+    bool cancelled;     // the trial stopped early on the cancellation deadline of its thread
+    const char* error;  // why FHDR ended without an output set, nullptr if it has one
+    std::string metrics;        // hot path metrics of FHDR as a JSON object, empty when compiled out
+    std::string sphere_metrics; // hot path metrics of Sphere-Adapt
+};
+
+// run FHDR (and Sphere-Adapt unless skipped or infeasible) on the skyline for the utility vector u
+// max_utility, when positive, is the largest utility of a skyline point for u (see max_utilities), which the regret
+// ratios are then computed with instead of a scan of the skyline
+experiment_outcome run_experiment_trial(point_set_t* skyline, point_t* u, const experiment_parameters& parameters,
+                                        double max_utility = 0);
+
+// the EXPERIMENT_RESULT records of a trial; trial_id, escaped for JSON, is added to every record when it is not empty
+std::string format_experiment_records(const experiment_outcome& outcome, const std::string& trial_id);
+
+// a single FHDR record with the given status and reason, for trials that could not be run
+std::string format_experiment_error(const char* status, const char* reason, const std::string& trial_id);
+
+// read and normalize a dataset; as in experiment mode, the prepared dataset is used as the skyline
+// with hull, the skyline is reduced to the hull vertices of the dataset (see hull_vertices), which hold the best point
+// for every utility vector, so regret ratios are unchanged while the questions are drawn from fewer points
+// the skyline shares its points with *dataset, release both with release_experiment_dataset
+point_set_t* prepare_experiment_dataset(char* input, point_set_t** dataset, bool hull = false);
+// prepare_experiment_dataset for a path that comes with a request: nullptr, instead of exiting, if the path has
+// MAX_FILENAME_LENG characters or more, is not a regular file, or does not hold a non-empty point file
+point_set_t* load_experiment_dataset(const std::string& path, point_set_t** dataset, bool hull = false);
+void release_experiment_dataset(point_set_t* skyline, point_set_t* dataset);
+
+// read a utility vector of the given dimension from a whitespace separated file, nullptr if invalid
+point_t* read_experiment_utility(const std::string& path, int dimension);
+
+// load and normalize the dataset once, then run every trial of the manifest on worker threads
+// each manifest line is: <trial_id> <utility_file> <seed> <d_int> <m> <w> <K> <q> <skip_sphere>
+// the largest utilities of the skyline for all the utility vectors are found in one pass before the trials
+int run_experiment_batch(char* input, const char* manifest, int num_threads, bool hull = false);
+
+#endif
@@ -1,11 +1,14 @@
 #include "experiment_random.h"
 
+#include "other/operation.h"
+
 #include <cstdlib>
 
 namespace {
 
+// one generator per thread, so that concurrent trials of a batch draw independent sequences
 std::mt19937& shared_generator(){
-    static std::mt19937 generator(std::random_device{}());
+    thread_local std::mt19937 generator(std::random_device{}());
     return generator;
 }
 
@@ -14,6 +17,7 @@ std::mt19937& shared_generator(){
 void seed_experiment_random(unsigned int seed){
     shared_generator().seed(seed);
     srand(seed);
+    seed_thread_rand(seed);
 }
 
 std::mt19937& experiment_random_generator(){
@@ -0,0 +1,194 @@
+#include "experiment_worker.h"
+#include "experiment.h"
+#include "experiment_random.h"
+#include "json_lines.h"
+#include "other/cancellation.h"
+#include "other/data_utility.h"
+#include "other/kernel_threads.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// a loaded dataset, with the skyline sharing its points
+struct cached_dataset{
+    std::string path;
+    point_set_t* dataset;
+    point_set_t* skyline;
+};
+
+// least recently used cache of prepared datasets, the most recent one at the front
+class dataset_cache{
+public:
+    dataset_cache(int capacity, bool hull) : capacity_(capacity < 1 ? 1 : capacity), hull_(hull) {}
+
+    ~dataset_cache(){
+        for (auto& entry : entries_) release_experiment_dataset(entry.skyline, entry.dataset);
+    }
+
+    // the prepared dataset at path, loading it when it is not cached; nullptr if it cannot be read
+    cached_dataset* get(const std::string& path){
+        for (auto it = entries_.begin(); it != entries_.end(); ++it){
+            if (it->path == path){
+                entries_.splice(entries_.begin(), entries_, it);
+                return &entries_.front();
+            }
+        }
+        // the path comes with the request, so it is checked rather than left to read_points, which exits
+        cached_dataset entry;
+        entry.path = path;
+        entry.skyline = load_experiment_dataset(path, &entry.dataset, hull_);
+        if (entry.skyline == nullptr) return nullptr;
+        entries_.push_front(entry);
+        while (entries_.size() > capacity_){
+            release_experiment_dataset(entries_.back().skyline, entries_.back().dataset);
+            entries_.pop_back();
+        }
+        return &entries_.front();
+    }
+
+private:
+    size_t capacity_;
+    bool hull_;
+    std::list<cached_dataset> entries_;
+};
+
+// trial_id is already escaped
+void write_done(FILE* out, const std::string& trial_id, const char* status){
+    fprintf(out, "EXPERIMENT_DONE {\"trial\":\"%s\",\"status\":\"%s\"}\n", trial_id.c_str(), status);
+    fflush(out);
+}
+
+// run one trial request and answer it on out
+void serve_request(const json_object& request, FILE* out, dataset_cache& cache){
+    std::string trial_id = json_escape(json_string(request, "trial"));
+    const char* required[] = {"dataset", "utility_file", "d_int", "m", "w", "K", "q"};
+    for (const char* key : required){
+        if (request.find(key) == request.end()){
+            fputs(format_experiment_error("error", "invalid_request", trial_id).c_str(), out);
+            write_done(out, trial_id, "error");
+            return;
+        }
+    }
+
+    cached_dataset* data = cache.get(json_string(request, "dataset"));
+    if (data == nullptr){
+        fputs(format_experiment_error("error", "invalid_dataset", trial_id).c_str(), out);
+        write_done(out, trial_id, "error");
+        return;
+    }
+    int d = data->dataset->points[0]->dim;
+    point_t* u = read_experiment_utility(json_string(request, "utility_file"), d);
+    if (u == nullptr){
+        fputs(format_experiment_error("error", "invalid_utility_file", trial_id).c_str(), out);
+        write_done(out, trial_id, "error");
+        return;
+    }
+
+    experiment_parameters parameters;
+    parameters.d_prime = json_int(request, "d_int", 0);
+    parameters.d_hat = json_int(request, "m", 0);
+    parameters.d_hat_2 = json_int(request, "w", 0);
+    parameters.K = json_int(request, "K", 0);
+    parameters.num_questions = json_int(request, "q", 0);
+    parameters.skip_sphere = json_bool(request, "skip_sphere", false);
+    if (!parse_cmp_option(json_string(request, "cmp", "random"), parameters.cmp_option)
+            || !parse_dom_option(json_string(request, "dom", "hyperplane"), parameters.dom_option)){
+        fputs(format_experiment_error("error", "invalid_request", trial_id).c_str(), out);
+        write_done(out, trial_id, "error");
+        release_point(u);
+        return;
+    }
+
+    seed_experiment_random(static_cast<unsigned int>(json_int(request, "seed", 0)));
+    // the trial stops cooperatively at its deadline, so the worker stays usable afterwards
+    set_thread_cancellation(json_double(request, "timeout", 0));
+    // workers that run side by side divide the cores for the parallel kernels of their trials
+    set_thread_kernel_threads(json_int(request, "threads", 0));
+    experiment_outcome outcome = run_experiment_trial(data->skyline, u, parameters);
+    clear_thread_cancellation();
+    release_point(u);
+
+    fputs(format_experiment_records(outcome, trial_id).c_str(), out);
+    write_done(out, trial_id, outcome.cancelled ? "timeout" : outcome.error != nullptr ? "error" : "ok");
+}
+
+// answer the requests read from in until end of input; false once a shutdown was requested
+bool serve_stream(FILE* in, FILE* out, dataset_cache& cache){
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    ssize_t length;
+    bool running = true;
+    while (running && (length = getline(&buffer, &capacity, in)) != -1){
+        std::string line(buffer, length);
+        if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+        json_object request;
+        if (!parse_json_object(line, request)){
+            fputs(format_experiment_error("error", "invalid_request", "").c_str(), out);
+            write_done(out, "", "error");
+            continue;
+        }
+        if (json_string(request, "op") == "shutdown"){
+            running = false;
+            continue;
+        }
+        serve_request(request, out, cache);
+    }
+    free(buffer);
+    return running;
+}
+
+int serve_socket(const char* socket_path, dataset_cache& cache){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)){
+        std::cerr << "Error: socket path too long: " << socket_path << "\n";
+        return 2;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 8) < 0){
+        std::cerr << "Error: cannot listen on " << socket_path << "\n";
+        if (listener >= 0) close(listener);
+        return 2;
+    }
+    // a client closing its connection early must not terminate the worker
+    signal(SIGPIPE, SIG_IGN);
+
+    // connections are served one at a time; the datasets stay cached across them
+    bool running = true;
+    while (running){
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) continue;
+        FILE* in = fdopen(connection, "r");
+        FILE* out = fdopen(dup(connection), "w");
+        if (in != NULL && out != NULL) running = serve_stream(in, out, cache);
+        if (out != NULL) fclose(out);
+        if (in != NULL) fclose(in);
+        else close(connection);
+    }
+    close(listener);
+    unlink(socket_path);
+    return 0;
+}
+
+} // namespace
+
+int run_experiment_worker(const char* socket_path, int cache_size, bool hull){
+    dataset_cache cache(cache_size, hull);
+    if (socket_path != nullptr) return serve_socket(socket_path, cache);
+    serve_stream(stdin, stdout, cache);
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef EXPERIMENT_WORKER_H
+#define EXPERIMENT_WORKER_H
+
+// serve experiment trials over a JSON-lines protocol, one request object per line:
+//   {"trial":"id","dataset":"path","utility_file":"path","seed":1,"d_int":3,"m":7,"w":6,"K":30,"q":15,
+//    "skip_sphere":false,"timeout":60}
+// every request is answered with its EXPERIMENT_RESULT records followed by
+//   EXPERIMENT_DONE {"trial":"id","status":"ok|timeout|error"}
+// requests are read from stdin and answered on stdout, or read from and answered on the connections of a
+// Unix domain socket when socket_path is not null. {"op":"shutdown"} stops the worker.
+// the most recently used cache_size datasets are kept loaded and normalized between requests, reduced to their hull
+// vertices with hull (see prepare_experiment_dataset)
+int run_experiment_worker(const char* socket_path, int cache_size, bool hull = false);
+
+#endif
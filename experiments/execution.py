@@ -2,8 +2,12 @@ from __future__ import annotations
 
 import hashlib
 import json
+import os
+import queue
 import random
 import subprocess
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from dataclasses import dataclass
 from pathlib import Path
 
@@ -11,6 +15,8 @@ from .config import REPOSITORY_ROOT, TrialConfiguration, UTILITY_APPROX_P1_MAX_R
 
 
 RESULT_PREFIX = "EXPERIMENT_RESULT "
+DONE_PREFIX = "EXPERIMENT_DONE "
+WORKER_GRACE_SECONDS = 30
 
 
 @dataclass(frozen=True)
@@ -83,6 +89,177 @@ def baseline_policy(configuration: TrialConfiguration) -> tuple[bool, bool]:
     return False, False
 
 
+@dataclass(frozen=True)
+class BatchEntry:
+    configuration: TrialConfiguration
+    trial: int
+    utility_file: Path
+    algorithm_seed: int
+
+    @property
+    def trial_id(self) -> str:
+        return f"{self.configuration.key}/{self.trial:03d}"
+
+
+def write_batch_manifest(path: Path, entries: list[BatchEntry]) -> None:
+    lines = ["# trial_id utility_file seed d_int m w K q skip_sphere"]
+    for entry in entries:
+        configuration = entry.configuration
+        skip_sphere, _ = baseline_policy(configuration)
+        lines.append(" ".join([
+            entry.trial_id, str(entry.utility_file), str(entry.algorithm_seed),
+            str(configuration.d_int), str(configuration.m), str(configuration.w),
+            str(configuration.output_size), str(configuration.question_budget),
+            "1" if skip_sphere else "0",
+        ]))
+    path.write_text("\n".join(lines) + "\n", encoding="utf-8")
+
+
+def group_batch_records(records: list[dict]) -> dict[str, list[dict]]:
+    grouped: dict[str, list[dict]] = {}
+    for record in records:
+        trial_id = record.pop("trial", None)
+        if trial_id is not None:
+            grouped.setdefault(trial_id, []).append(record)
+    return grouped
+
+
+def run_fhdr_batch(
+    dataset_path: Path,
+    entries: list[BatchEntry],
+    threads: int,
+    timeout: int,
+    manifest_path: Path,
+    executable: str = "run",
+) -> tuple[dict[str, list[dict]], str]:
+    """Run the FHDR trials of one dataset in a single process that loads the dataset once."""
+    write_batch_manifest(manifest_path, entries)
+    command = [
+        str(REPOSITORY_ROOT / executable), "--batch", str(dataset_path),
+        str(manifest_path), str(threads),
+    ]
+    batch_timeout = timeout * max(1, -(-len(entries) // max(1, threads)))
+    process = run_process(command, batch_timeout)
+    log = "$ " + " ".join(command) + "\n" + process.stdout + process.stderr
+    return group_batch_records(process.records), log
+
+
+def worker_request(dataset_path: Path, entry: BatchEntry, timeout: int, threads: int = 0) -> dict:
+    configuration = entry.configuration
+    skip_sphere, _ = baseline_policy(configuration)
+    return {
+        "trial": entry.trial_id, "dataset": str(dataset_path),
+        "utility_file": str(entry.utility_file), "seed": entry.algorithm_seed,
+        "d_int": configuration.d_int, "m": configuration.m, "w": configuration.w,
+        "K": configuration.output_size, "q": configuration.question_budget,
+        "skip_sphere": skip_sphere, "timeout": timeout, "threads": threads,
+    }
+
+
+class ExperimentWorker:
+    """A long-lived `run --worker` process that keeps prepared datasets loaded between trials."""
+
+    def __init__(self) -> None:
+        self.process: subprocess.Popen | None = None
+        self.lines: queue.Queue[str | None] = queue.Queue()
+
+    def start(self) -> None:
+        self.process = subprocess.Popen(
+            [str(REPOSITORY_ROOT / "run"), "--worker"], cwd=REPOSITORY_ROOT, text=True,
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, bufsize=1,
+        )
+        self.lines = queue.Queue()
+        threading.Thread(target=self._read, args=(self.process.stdout, self.lines), daemon=True).start()
+
+    @staticmethod
+    def _read(stream, lines: queue.Queue) -> None:
+        for line in stream:
+            lines.put(line)
+        lines.put(None)
+
+    def run(self, request: dict, timeout: int) -> tuple[list[dict], str]:
+        """Send one trial request and collect its records.
+
+        The worker stops the trial itself at the request timeout; the process is only
+        killed (and restarted by the next request) when it does not answer in time.
+        """
+        if self.process is None or self.process.poll() is not None:
+            self.start()
+        assert self.process is not None and self.process.stdin is not None
+        log = "> " + json.dumps(request) + "\n"
+        try:
+            self.process.stdin.write(json.dumps(request) + "\n")
+            self.process.stdin.flush()
+        except BrokenPipeError:
+            self.close()
+            return [], log + "WORKER EXITED\n"
+        output = []
+        while True:
+            try:
+                line = self.lines.get(timeout=timeout + WORKER_GRACE_SECONDS)
+            except queue.Empty:
+                self.close()
+                return [], log + "".join(output) + f"\nTIMEOUT after {timeout} seconds\n"
+            if line is None:
+                self.close()
+                return [], log + "".join(output) + "\nWORKER EXITED\n"
+            output.append(line)
+            if line.startswith(DONE_PREFIX) and json.loads(line[len(DONE_PREFIX):]).get("trial") == request["trial"]:
+                text = "".join(output)
+                return parse_records(text), log + text
+
+    def close(self) -> None:
+        if self.process is None:
+            return
+        if self.process.poll() is None:
+            try:
+                self.process.stdin.write(json.dumps({"op": "shutdown"}) + "\n")
+                self.process.stdin.close()
+                self.process.wait(timeout=5)
+            except (BrokenPipeError, subprocess.TimeoutExpired):
+                self.process.kill()
+                self.process.wait()
+        self.process = None
+
+
+class WorkerPool:
+    """A fixed set of experiment workers shared by all configurations of a run."""
+
+    def __init__(self, size: int) -> None:
+        self.idle: queue.Queue[ExperimentWorker] = queue.Queue()
+        self.size = size
+        for _ in range(size):
+            self.idle.put(ExperimentWorker())
+
+    def _run(self, request: dict, timeout: int) -> tuple[list[dict], str]:
+        worker = self.idle.get()
+        try:
+            return worker.run(request, timeout)
+        finally:
+            self.idle.put(worker)
+
+    def run_fhdr(
+        self, dataset_path: Path, entries: list[BatchEntry], timeout: int,
+    ) -> tuple[dict[str, list[dict]], str]:
+        """Run the FHDR trials on the workers; records are grouped by trial id like a batch run."""
+        threads = max(1, (os.cpu_count() or 1) // self.size)
+        requests = [worker_request(dataset_path, entry, timeout, threads) for entry in entries]
+        with ThreadPoolExecutor(max_workers=self.size) as executor:
+            results = list(executor.map(lambda request: self._run(request, timeout), requests))
+        records = [record for trial_records, _ in results for record in trial_records]
+        return group_batch_records(records), "".join(log for _, log in results)
+
+    def close(self) -> None:
+        for _ in range(self.size):
+            self.idle.get().close()
+
+    def __enter__(self) -> WorkerPool:
+        return self
+
+    def __exit__(self, *exc_info) -> None:
+        self.close()
+
+
 def run_trial(
     configuration: TrialConfiguration,
     trial: int,
@@ -90,25 +267,30 @@ def run_trial(
     algorithm_seed: int,
     timeout: int,
     dataset_path: Path | None = None,
+    fhdr_records: list[dict] | None = None,
 ) -> tuple[list[dict], str]:
     skip_sphere, skip_utility_approx = baseline_policy(configuration)
     active_dataset_path = dataset_path or configuration.dataset.path
-    fhdr_command = [
-        str(REPOSITORY_ROOT / "run"), "--experiment", str(active_dataset_path),
-        str(configuration.d_int), str(configuration.m), str(configuration.w),
-        str(configuration.output_size), str(configuration.question_budget),
-        str(utility_file), str(algorithm_seed), "1" if skip_sphere else "0",
-    ]
-    fhdr_process = run_process(fhdr_command, timeout)
-    fhdr = next((record for record in fhdr_process.records if record["method"] == "FHDR"), None)
+    if fhdr_records is None:
+        fhdr_command = [
+            str(REPOSITORY_ROOT / "run"), "--experiment", str(active_dataset_path),
+            str(configuration.d_int), str(configuration.m), str(configuration.w),
+            str(configuration.output_size), str(configuration.question_budget),
+            str(utility_file), str(algorithm_seed), "1" if skip_sphere else "0",
+        ]
+        fhdr_process = run_process(fhdr_command, timeout)
+        fhdr_records = fhdr_process.records
+        log = "$ " + " ".join(fhdr_command) + "\n" + fhdr_process.stdout + fhdr_process.stderr
+    else:
+        log = "(FHDR records from batch run)\n"
+    fhdr = next((record for record in fhdr_records
+                 if record["method"] == "FHDR" and record["status"] == "ok"), None)
     if fhdr is None:
         raise RuntimeError(
-            f"FHDR trial failed for {configuration.key}, trial {trial}\n"
-            f"stdout:\n{fhdr_process.stdout}\nstderr:\n{fhdr_process.stderr}"
+            f"FHDR trial failed for {configuration.key}, trial {trial}\n{log}"
         )
 
-    records = list(fhdr_process.records)
-    log = "$ " + " ".join(fhdr_command) + "\n" + fhdr_process.stdout + fhdr_process.stderr
+    records = list(fhdr_records)
 
     if skip_utility_approx:
         records.append({
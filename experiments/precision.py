@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Compare the FHDR results of the double and the single-precision (`make float`) builds."""
+from __future__ import annotations
+
+import argparse
+import csv
+import json
+import math
+import subprocess
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+if __package__ in {None, ""}:
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    from experiments.config import REPOSITORY_ROOT, experiment_configurations
+    from experiments.datasets import ensure_dataset, prepared_dataset_path
+    from experiments.execution import (
+        BatchEntry, ensure_utility, run_fhdr_batch, stable_seed, utility_path,
+    )
+else:
+    from .config import REPOSITORY_ROOT, experiment_configurations
+    from .datasets import ensure_dataset, prepared_dataset_path
+    from .execution import BatchEntry, ensure_utility, run_fhdr_batch, stable_seed, utility_path
+
+
+BUILDS = {"double": "run", "float": "run_float"}
+COMPARED_FIELDS = ["output_size", "questions"]
+
+
+def parse_arguments() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--part", choices=["p1", "p2", "internal"], required=True)
+    parser.add_argument("--vary", required=True, help="Parameter to vary: d_int, n, d, q, K, m, or w")
+    parser.add_argument("--dataset", default="synthetic",
+                        help="synthetic, house, car, nba, energy, or real")
+    parser.add_argument("--runs", type=int, default=20)
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--timeout", type=int, default=3600, help="Per-trial timeout in seconds")
+    parser.add_argument("--threads", type=int, default=1, help="Worker threads of each batch process")
+    parser.add_argument("--tolerance", type=float, default=1e-6,
+                        help="Largest regret ratio difference that counts as unchanged")
+    parser.add_argument("--run-id", default="precision")
+    parser.add_argument("--no-build", action="store_true", help="Use the existing executables")
+    arguments = parser.parse_args()
+    if arguments.runs <= 0 or arguments.timeout <= 0 or arguments.threads <= 0:
+        parser.error("--runs, --timeout and --threads must be positive")
+    if arguments.vary.lower() == "k":
+        arguments.vary = "K"
+    return arguments
+
+
+def compare_records(
+    trial_id: str, double_records: list[dict], float_records: list[dict],
+) -> list[dict]:
+    """One row per method that completed in both builds."""
+    rows = []
+    float_by_method = {record["method"]: record for record in float_records if record.get("status") == "ok"}
+    for record in double_records:
+        other = float_by_method.get(record["method"])
+        if record.get("status") != "ok" or other is None:
+            continue
+        row = {
+            "trial": trial_id, "method": record["method"],
+            "regret_ratio_double": float(record["regret_ratio"]),
+            "regret_ratio_float": float(other["regret_ratio"]),
+        }
+        row["regret_ratio_difference"] = abs(row["regret_ratio_double"] - row["regret_ratio_float"])
+        for field in COMPARED_FIELDS:
+            row[f"{field}_double"] = record[field]
+            row[f"{field}_float"] = other[field]
+        rows.append(row)
+    return rows
+
+
+def summarize(rows: list[dict], tolerance: float) -> list[dict]:
+    grouped: dict[str, list[dict]] = defaultdict(list)
+    for row in rows:
+        grouped[row["method"]].append(row)
+    summaries = []
+    for method, method_rows in sorted(grouped.items()):
+        differences = [row["regret_ratio_difference"] for row in method_rows]
+        summary = {
+            "method": method,
+            "trials": len(method_rows),
+            "max_regret_ratio_difference": max(differences),
+            "mean_regret_ratio_difference": math.fsum(differences) / len(differences),
+            "regret_ratio_changed": sum(difference > tolerance for difference in differences),
+        }
+        for field in COMPARED_FIELDS:
+            summary[f"{field}_changed"] = sum(
+                row[f"{field}_double"] != row[f"{field}_float"] for row in method_rows
+            )
+        summaries.append(summary)
+    return summaries
+
+
+def main() -> int:
+    arguments = parse_arguments()
+    if not arguments.no_build:
+        subprocess.run(["make", "all", "float"], cwd=REPOSITORY_ROOT, check=True)
+    result_root = REPOSITORY_ROOT / "results" / arguments.run_id
+    output_directory = result_root / arguments.part / arguments.dataset / f"vary_{arguments.vary}"
+    output_directory.mkdir(parents=True, exist_ok=True)
+
+    rows = []
+    failures = 0
+    for configuration in experiment_configurations(arguments.part, arguments.vary, arguments.dataset):
+        ensure_dataset(configuration.dataset)
+        dataset_path = prepared_dataset_path(configuration.dataset, result_root)
+        entries = []
+        for trial in range(arguments.runs):
+            utility_seed = stable_seed(
+                arguments.seed, "utility", configuration.dataset.dimension, configuration.d_int, trial,
+            )
+            trial_utility_path = utility_path(result_root, configuration, trial)
+            ensure_utility(trial_utility_path, configuration.dataset.dimension,
+                           configuration.d_int, utility_seed)
+            algorithm_seed = stable_seed(arguments.seed, "algorithm", configuration.key, trial)
+            entries.append(BatchEntry(configuration, trial, trial_utility_path, algorithm_seed))
+
+        print(f"Precision {configuration.key}: {len(entries)} trials", flush=True)
+        records = {}
+        for build, executable in BUILDS.items():
+            log_path = output_directory / "logs" / configuration.key / f"{build}.log"
+            log_path.parent.mkdir(parents=True, exist_ok=True)
+            records[build], log = run_fhdr_batch(
+                dataset_path, entries, arguments.threads, arguments.timeout,
+                log_path.with_name(f"{build}_manifest.txt"), executable,
+            )
+            log_path.write_text(log, encoding="utf-8")
+        for entry in entries:
+            compared = compare_records(
+                entry.trial_id, records["double"].get(entry.trial_id, []),
+                records["float"].get(entry.trial_id, []),
+            )
+            if not compared:
+                failures += 1
+            rows.extend(compared)
+
+    if not rows:
+        raise RuntimeError("no trial completed in both builds")
+    with (output_directory / "precision.csv").open("w", newline="", encoding="utf-8") as target:
+        writer = csv.DictWriter(target, fieldnames=list(rows[0]))
+        writer.writeheader()
+        writer.writerows(rows)
+    summaries = summarize(rows, arguments.tolerance)
+    report = {"tolerance": arguments.tolerance, "incomplete_trials": failures, "methods": summaries}
+    (output_directory / "precision.json").write_text(json.dumps(report, indent=2) + "\n", encoding="utf-8")
+
+    for summary in summaries:
+        print(
+            f"{summary['method']}: {summary['trials']} trials, max regret ratio difference "
+            f"{summary['max_regret_ratio_difference']:.3g}, {summary['regret_ratio_changed']} above "
+            f"{arguments.tolerance:g}, {summary['output_size_changed']} output sizes and "
+            f"{summary['questions_changed']} question counts changed"
+        )
+    print(f"Report: {output_directory / 'precision.json'}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -15,13 +15,19 @@ if __package__ in {None, ""}:
         DEFAULT_RUNS, REPOSITORY_ROOT, experiment_configurations, paper_suite,
     )
     from experiments.datasets import ensure_dataset, prepared_dataset_path, sha256_file
-    from experiments.execution import ensure_utility, run_trial, stable_seed, utility_path
+    from experiments.execution import (
+        BatchEntry, WorkerPool, ensure_utility, run_fhdr_batch, run_trial, stable_seed,
+        utility_path,
+    )
     from experiments.plotting import generate_plots
 else:
     from .aggregation import aggregate
     from .config import DEFAULT_RUNS, REPOSITORY_ROOT, experiment_configurations, paper_suite
     from .datasets import ensure_dataset, prepared_dataset_path, sha256_file
-    from .execution import ensure_utility, run_trial, stable_seed, utility_path
+    from .execution import (
+        BatchEntry, WorkerPool, ensure_utility, run_fhdr_batch, run_trial, stable_seed,
+        utility_path,
+    )
     from .plotting import generate_plots
 
 
@@ -36,6 +42,12 @@ def parse_arguments() -> argparse.Namespace:
     parser.add_argument("--seed", type=int, default=42)
     parser.add_argument("--timeout", type=int, default=3600,
                         help="Per-process timeout in seconds")
+    parser.add_argument("--batch-threads", type=int, default=0,
+                        help="Run the FHDR trials of each configuration in one batch process "
+                             "with this many worker threads (0 starts one process per trial)")
+    parser.add_argument("--workers", type=int, default=0,
+                        help="Run the FHDR trials on this many long-lived worker processes that "
+                             "keep datasets loaded across configurations (0 disables the pool)")
     parser.add_argument("--run-id", default="paper")
     parser.add_argument("--plot-only", action="store_true")
     parser.add_argument("--no-generate", action="store_true",
@@ -45,6 +57,10 @@ def parse_arguments() -> argparse.Namespace:
         parser.error("provide --part and --vary, or use --suite paper")
     if arguments.runs <= 0 or arguments.timeout <= 0:
         parser.error("--runs and --timeout must be positive")
+    if arguments.batch_threads < 0 or arguments.workers < 0:
+        parser.error("--batch-threads and --workers must not be negative")
+    if arguments.batch_threads > 0 and arguments.workers > 0:
+        parser.error("use either --batch-threads or --workers")
     if arguments.vary and arguments.vary.lower() == "k":
         arguments.vary = "K"
     return arguments
@@ -76,6 +92,8 @@ def run_experiment(
     timeout: int,
     generate_missing: bool,
     plot_only: bool,
+    batch_threads: int = 0,
+    worker_pool: WorkerPool | None = None,
 ) -> list[Path]:
     configurations = experiment_configurations(part, vary, dataset_selector)
     output_directory = experiment_directory(result_root, part, vary, dataset_selector)
@@ -128,6 +146,7 @@ def run_experiment(
         completed_count = 0
         total_count = len(configurations) * runs
         for configuration in configurations:
+            pending = []
             for trial in range(runs):
                 trial_path = raw_directory / configuration.key / f"trial_{trial:03d}.json"
                 if trial_path.exists():
@@ -143,13 +162,42 @@ def run_experiment(
                     trial_utility_path, configuration.dataset.dimension,
                     configuration.d_int, utility_seed,
                 )
+                pending.append((
+                    BatchEntry(configuration, trial, trial_utility_path, algorithm_seed),
+                    trial_path, utility_seed, utility_sha256,
+                ))
+
+            batch_records = None
+            if batch_threads > 0 and pending:
+                print(f"Batch {configuration.key}: {len(pending)} trials on {batch_threads} threads",
+                      flush=True)
+                batch_log_path = logs_directory / configuration.key / "batch.log"
+                batch_log_path.parent.mkdir(parents=True, exist_ok=True)
+                batch_records, batch_log = run_fhdr_batch(
+                    prepared_paths[configuration.dataset.name], [entry for entry, *_ in pending],
+                    batch_threads, timeout, batch_log_path.with_name("batch_manifest.txt"),
+                )
+                batch_log_path.write_text(batch_log, encoding="utf-8")
+            elif worker_pool is not None and pending:
+                print(f"Workers {configuration.key}: {len(pending)} trials on {worker_pool.size} workers",
+                      flush=True)
+                worker_log_path = logs_directory / configuration.key / "workers.log"
+                worker_log_path.parent.mkdir(parents=True, exist_ok=True)
+                batch_records, worker_log = worker_pool.run_fhdr(
+                    prepared_paths[configuration.dataset.name], [entry for entry, *_ in pending], timeout,
+                )
+                worker_log_path.write_text(worker_log, encoding="utf-8")
+
+            for entry, trial_path, utility_seed, utility_sha256 in pending:
+                trial = entry.trial
                 print(
                     f"[{completed_count + 1}/{total_count}] {configuration.key} trial {trial + 1}/{runs}",
                     flush=True,
                 )
                 records, log = run_trial(
-                    configuration, trial, trial_utility_path, algorithm_seed, timeout,
+                    configuration, trial, entry.utility_file, entry.algorithm_seed, timeout,
                     prepared_paths[configuration.dataset.name],
+                    None if batch_records is None else batch_records.get(entry.trial_id, []),
                 )
                 configuration_data = configuration.serializable()
                 configuration_data["key"] = configuration.key
@@ -157,7 +205,7 @@ def run_experiment(
                     "configuration": configuration_data,
                     "trial": trial,
                     "utility_seed": utility_seed,
-                    "algorithm_seed": algorithm_seed,
+                    "algorithm_seed": entry.algorithm_seed,
                     "utility_sha256": utility_sha256,
                     "results": records,
                 }
@@ -188,11 +236,17 @@ def main() -> int:
     experiments = paper_suite() if arguments.suite else [
         (arguments.part, arguments.vary, arguments.dataset)
     ]
-    for part, vary, dataset in experiments:
-        run_experiment(
-            part, vary, dataset, result_root, arguments.runs, arguments.seed,
-            arguments.timeout, not arguments.no_generate, arguments.plot_only,
-        )
+    worker_pool = WorkerPool(arguments.workers) if arguments.workers > 0 and not arguments.plot_only else None
+    try:
+        for part, vary, dataset in experiments:
+            run_experiment(
+                part, vary, dataset, result_root, arguments.runs, arguments.seed,
+                arguments.timeout, not arguments.no_generate, arguments.plot_only,
+                arguments.batch_threads, worker_pool,
+            )
+    finally:
+        if worker_pool is not None:
+            worker_pool.close()
     return 0
 
 
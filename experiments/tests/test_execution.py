@@ -3,7 +3,10 @@ import unittest
 from pathlib import Path
 
 from experiments.config import DatasetSpec, REPOSITORY_ROOT, TrialConfiguration
-from experiments.execution import baseline_policy, ensure_utility, parse_records, run_trial
+from experiments.execution import (
+    BatchEntry, ExperimentWorker, baseline_policy, ensure_utility, group_batch_records, parse_records, run_trial,
+    worker_request, write_batch_manifest,
+)
 
 
 class ExecutionTest(unittest.TestCase):
@@ -11,6 +14,60 @@ class ExecutionTest(unittest.TestCase):
         records = parse_records('noise\nEXPERIMENT_RESULT {"method":"FHDR","status":"ok"}\n')
         self.assertEqual(records, [{"method": "FHDR", "status": "ok"}])
 
+    def test_batch_manifest_and_record_grouping(self):
+        configuration = TrialConfiguration(
+            part="p2", vary="d",
+            dataset=DatasetSpec("d", Path("d"), 100_000, 200, True),
+            parameter_value=200, d_int=3, m=7, w=6,
+            output_size=30, question_budget=15,
+        )
+        entries = [BatchEntry(configuration, trial, Path(f"u{trial}.txt"), 10 + trial) for trial in range(2)]
+        with tempfile.TemporaryDirectory() as directory:
+            manifest = Path(directory) / "manifest.txt"
+            write_batch_manifest(manifest, entries)
+            lines = manifest.read_text().splitlines()
+        self.assertEqual(lines[1], "d__d_200/000 u0.txt 10 3 7 6 30 15 1")
+        self.assertEqual(len(lines), 3)
+        grouped = group_batch_records(parse_records(
+            'EXPERIMENT_RESULT {"method":"FHDR","status":"ok","trial":"d__d_200/001"}\n'
+            'EXPERIMENT_RESULT {"method":"Sphere-Adapt","status":"unavailable","trial":"d__d_200/001"}\n'
+        ))
+        self.assertEqual(list(grouped), [entries[1].trial_id])
+        self.assertEqual(grouped[entries[1].trial_id][0], {"method": "FHDR", "status": "ok"})
+
+    def test_worker_request(self):
+        configuration = TrialConfiguration(
+            part="p2", vary="q",
+            dataset=DatasetSpec("d", Path("d"), 100_000, 20, True),
+            parameter_value=15, d_int=3, m=7, w=6,
+            output_size=30, question_budget=15,
+        )
+        request = worker_request(Path("data.txt"), BatchEntry(configuration, 4, Path("u.txt"), 99), 60)
+        self.assertEqual(request["trial"], "d__q_15/004")
+        self.assertEqual((request["dataset"], request["utility_file"], request["seed"]), ("data.txt", "u.txt", 99))
+        self.assertEqual((request["d_int"], request["m"], request["w"], request["K"], request["q"]), (3, 7, 6, 30, 15))
+        self.assertEqual((request["skip_sphere"], request["timeout"], request["threads"]), (False, 60, 0))
+
+    def test_worker_rejects_unreadable_datasets(self):
+        worker = ExperimentWorker()
+        try:
+            with tempfile.TemporaryDirectory() as directory:
+                # a readable point file whose path is longer than the reader's file name buffer
+                deep = Path(directory, "a" * 100, "b" * 100, "c" * 100)
+                deep.mkdir(parents=True)
+                (deep / "points.txt").write_text("2 2\n0.5 0.5\n1 0\n")
+                malformed = Path(directory) / "malformed.txt"
+                malformed.write_text("not a point file\n")
+                for dataset in [deep / "points.txt", Path(directory), malformed]:
+                    request = {
+                        "trial": "t", "dataset": str(dataset), "utility_file": "u.txt", "seed": 1,
+                        "d_int": 1, "m": 1, "w": 1, "K": 1, "q": 1, "timeout": 60,
+                    }
+                    records, log = worker.run(request, 60)
+                    self.assertEqual([record["reason"] for record in records], ["invalid_dataset"], log)
+        finally:
+            worker.close()
+
     def test_infeasible_baseline_policy(self):
         million_points = TrialConfiguration(
             part="p2", vary="n",
@@ -0,0 +1,30 @@
+import unittest
+
+from experiments.precision import compare_records, summarize
+
+
+class PrecisionTest(unittest.TestCase):
+    def test_compare_and_summarize(self):
+        double_records = [
+            {"method": "FHDR", "status": "ok", "regret_ratio": 0.1, "output_size": 30, "questions": 15},
+            {"method": "Sphere-Adapt", "status": "ok", "regret_ratio": 0.2, "output_size": 30, "questions": 15},
+        ]
+        float_records = [
+            {"method": "FHDR", "status": "ok", "regret_ratio": 0.1 + 1e-8, "output_size": 30, "questions": 15},
+            {"method": "Sphere-Adapt", "status": "unavailable", "reason": "cancelled"},
+        ]
+        rows = compare_records("t/000", double_records, float_records)
+        self.assertEqual([row["method"] for row in rows], ["FHDR"])
+        rows += compare_records("t/001", double_records[:1], [
+            {"method": "FHDR", "status": "ok", "regret_ratio": 0.15, "output_size": 29, "questions": 15},
+        ])
+        summary, = summarize(rows, 1e-6)
+        self.assertEqual(summary["trials"], 2)
+        self.assertAlmostEqual(summary["max_regret_ratio_difference"], 0.05)
+        self.assertEqual(summary["regret_ratio_changed"], 1)
+        self.assertEqual(summary["output_size_changed"], 1)
+        self.assertEqual(summary["questions_changed"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,149 @@
+import json
+import subprocess
+import tempfile
+import time
+import unittest
+from pathlib import Path
+
+from experiments.config import REPOSITORY_ROOT
+
+DATASET = REPOSITORY_ROOT / "datasets/real/nba.txt"
+# nba has d = 104, so with m = 8 phase 1 asks 13 block questions and leaves no tail dimension
+PARAMETERS = {"dataset": str(DATASET), "seed": 1, "m": 8, "w": 6, "K": 30, "q": 30}
+BLOCKS = 13
+
+
+class SessionServer:
+    def __init__(self, *arguments):
+        self.process = subprocess.Popen(
+            [str(REPOSITORY_ROOT / "run"), "--serve", *arguments], cwd=REPOSITORY_ROOT,
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True,
+        )
+
+    def send(self, request):
+        self.process.stdin.write(json.dumps(request) + "\n")
+        self.process.stdin.flush()
+
+    def receive(self):
+        # the sessions also log to standard output; only the protocol lines are responses
+        while True:
+            line = self.process.stdout.readline()
+            if not line:
+                raise AssertionError(f"server exited with {self.process.wait()}")
+            kind, _, payload = line.partition(" ")
+            if kind.startswith(("SESSION_", "SERVER_")):
+                return kind, json.loads(payload)
+
+    def request(self, request):
+        self.send(request)
+        return self.receive()
+
+    def open(self, session, dataset=DATASET, **options):
+        return self.request({"op": "open", "session": session, **PARAMETERS, "dataset": str(dataset), **options})
+
+    def answer(self, session, answer, think=0.0):
+        # speculation runs the possible answers while the user thinks
+        time.sleep(think)
+        return self.request({"op": "answer", "session": session, "answer": answer})
+
+    def shutdown(self):
+        self.send({"op": "shutdown"})
+        kind, stats = self.receive()
+        self.process.communicate(timeout=60)
+        return kind, stats
+
+
+def drive(server, session, answers, think=0.0):
+    """Give the answers in order, the last one after think seconds, and then 0 until the session ends: the first
+    point, or no interest in a dimension."""
+    kind, response = server.open(session)
+    for i, answer in enumerate(answers):
+        assert kind == "SESSION_QUESTION", (kind, response)
+        kind, response = server.answer(session, answer, think if i == len(answers) - 1 else 0.0)
+    while kind == "SESSION_QUESTION":
+        kind, response = server.answer(session, 0)
+    return kind, response
+
+
+class SessionServerTest(unittest.TestCase):
+    def test_sessions_without_dimensions_end_alone(self):
+        server = SessionServer("--threads", "1", "--speculate", "0")
+        try:
+            self.assertEqual(server.open("bystander")[0], "SESSION_QUESTION")
+            # no block is interesting
+            kind, response = drive(server, "all-none", [-1] * BLOCKS)
+            self.assertEqual((kind, response["reason"]), ("SESSION_ERROR", "no_candidate_dimensions"))
+            # the first block is, but none of its 8 dimensions
+            kind, response = drive(server, "all-reject", [0] + [-1] * (BLOCKS - 1))
+            self.assertEqual((kind, response["reason"]), ("SESSION_ERROR", "no_candidate_dimensions"))
+            # all but one of them
+            kind, response = drive(server, "one-dimension", [0] + [-1] * (BLOCKS - 1) + [1])
+            self.assertEqual((kind, response["dimensions"], len(response["points"])), ("SESSION_RESULT", [0], 1))
+            self.assertEqual(server.answer("bystander", 0)[0], "SESSION_QUESTION")
+        finally:
+            kind, stats = server.shutdown()
+        self.assertEqual(kind, "SERVER_STATS")
+        self.assertEqual((stats["sessions_active"], stats["sessions_finished"]), (1, 1))
+        self.assertEqual(server.process.returncode, 0)
+
+
+    def test_failing_speculation_is_a_miss(self):
+        server = SessionServer("--threads", "2", "--speculate", "4")
+        try:
+            # the "none" answer to the last block is prepared while the user thinks, fails, and then comes in
+            kind, response = drive(server, "all-none", [-1] * BLOCKS, think=1.0)
+            self.assertEqual((kind, response["reason"]), ("SESSION_ERROR", "no_candidate_dimensions"))
+            # the "no" answer to the last dimension is prepared and fails, but the user answers "yes"
+            kind, _ = drive(server, "last-dimension", [0] + [-1] * (BLOCKS - 1) + [0] * 7 + [1], think=1.0)
+            self.assertEqual(kind, "SESSION_RESULT")
+        finally:
+            kind, stats = server.shutdown()
+        self.assertEqual(kind, "SERVER_STATS")
+        self.assertEqual(stats["sessions_finished"], 1)
+        self.assertGreaterEqual(stats["speculation_misses"], 1)
+        self.assertEqual(server.process.returncode, 0)
+
+    def test_unreadable_datasets_are_rejected(self):
+        server = SessionServer("--threads", "1", "--speculate", "0", "--cache", "1")
+        try:
+            with tempfile.TemporaryDirectory() as directory:
+                # a readable point file whose path is longer than the reader's file name buffer
+                deep = Path(directory, "a" * 100, "b" * 100, "c" * 100)
+                deep.mkdir(parents=True)
+                (deep / "points.txt").write_text("2 2\n0.5 0.5\n1 0\n")
+                malformed = Path(directory) / "malformed.txt"
+                malformed.write_text("not a point file\n")
+                for name, dataset in [("long", deep / "points.txt"), ("directory", directory), ("malformed", malformed)]:
+                    kind, response = server.open(name, dataset)
+                    self.assertEqual((kind, response["reason"]), ("SESSION_ERROR", "invalid_dataset"))
+                # with a cache of one dataset, the small one replaces nba, which stays loaded for its open session
+                small = Path(directory) / "small.txt"
+                lines = DATASET.read_text().splitlines()
+                small.write_text("\n".join(["200 " + lines[0].split()[1]] + lines[1:201]) + "\n")
+                self.assertEqual(server.open("nba")[0], "SESSION_QUESTION")
+                self.assertEqual(server.open("small", small)[0], "SESSION_QUESTION")
+                self.assertEqual(server.answer("nba", 0)[0], "SESSION_QUESTION")
+        finally:
+            kind, stats = server.shutdown()
+        self.assertEqual((kind, stats["sessions_active"]), ("SERVER_STATS", 2))
+        self.assertEqual(server.process.returncode, 0)
+
+    def test_question_and_pruning_modes(self):
+        server = SessionServer("--threads", "1", "--speculate", "0")
+        try:
+            for name, options in [("unknown-cmp", {"cmp": "unknown"}), ("unknown-dom", {"dom": "unknown"})]:
+                kind, response = server.open(name, **options)
+                self.assertEqual((kind, response["reason"]), ("SESSION_ERROR", "invalid_request"))
+            for name, options in [("simplex", {"cmp": "simplex"}), ("halfspace", {"dom": "halfspace"})]:
+                kind, response = server.open(name, **options)
+                while kind == "SESSION_QUESTION":
+                    kind, response = server.answer(name, 0)
+                self.assertEqual((kind, len(response["points"])), ("SESSION_RESULT", PARAMETERS["K"]))
+        finally:
+            kind, stats = server.shutdown()
+        self.assertEqual((kind, stats["sessions_finished"]), ("SERVER_STATS", 2))
+        self.assertEqual(server.process.returncode, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
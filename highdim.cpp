@@ -1,5 +1,12 @@
 #include "highdim.h"
 #include "experiment_random.h"
+#include "other/metrics.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
 
 namespace {
 
@@ -11,14 +18,6 @@ std::vector<int> dimension_range(int start, int count){
     return dimensions;
 }
 
-std::vector<int> selected_dimension_slice(const std::set<int>& selected_dimensions, int start, int count){
-    std::vector<int> dimensions;
-    for (int i = 0; i < count; ++i) {
-        dimensions.push_back(*next(selected_dimensions.begin(), start + i));
-    }
-    return dimensions;
-}
-
 point_set_t* project_points(point_set_t* source, const std::vector<int>& dimensions){
     point_set_t* projected = alloc_point_set(source->numberOfPoints);
     for (int i = 0; i < source->numberOfPoints; ++i){
@@ -28,80 +27,93 @@ point_set_t* project_points(point_set_t* source, const std::vector<int>& dimensi
             projected->points[i]->coord[j] = source->points[i]->coord[dimensions[j]];
         }
     }
+    metric_add(METRIC_PROJECTIONS);
+    metric_add(METRIC_PROJECTED_POINTS, source->numberOfPoints);
     return projected;
 }
 
-point_set_t* select_random_points(point_set_t* D, int size){
-    point_set_t* S = alloc_point_set(size);
-    std::uniform_int_distribution<int> dis(0, D->numberOfPoints-1);
-    // select size points from D
+// the positions of size random points of the skyline, drawn with replacement
+std::vector<int> select_random_positions(point_set_t* skyline, int size, std::mt19937& generator){
+    std::vector<int> positions;
+    std::uniform_int_distribution<int> dis(0, skyline->numberOfPoints-1);
     for (int i = 0; i < size; ++i) {
-        int idx = dis(experiment_random_generator());
-        S->points[i] = D->points[idx];
+        positions.push_back(dis(generator));
     }
-    return S;
+    return positions;
 }
 
-point_t* project_utility(point_t* u, const std::vector<int>& dimensions){
-    point_t* u_hat = alloc_point(dimensions.size());
-    for (int i = 0; i < dimensions.size(); ++i) {
-        u_hat->coord[i] = u->coord[dimensions[i]];
-    }
-    return u_hat;
-}
-
-int simulated_choice_id(point_set_t* S, point_t* u_hat){
-    double maxValue = 0;
-    int maxIdx = 0;
-    for (int i = 0; i < S->numberOfPoints; i++) {
-        double value = dot_prod(u_hat, S->points[i]);
-        if (value > maxValue) {
-            maxValue = value;
-            maxIdx = i;
-        }
+std::vector<point_t*> skyline_points(point_set_t* skyline, const std::vector<int>& positions){
+    std::vector<point_t*> points;
+    for (int position : positions) {
+        points.push_back(skyline->points[position]);
     }
-    return maxValue > 0 ? S->points[maxIdx]->id : -1;
+    return points;
 }
 
-void record_question(question_mapping& qm, const std::vector<int>& dimensions, point_set_t* S, int id){
+void record_question(question_mapping& qm, const std::vector<int>& dimensions, const std::vector<point_t*>& points, int id){
     // Record the question: dimensions shown and tuple indices (selected first)
-    std::set<int> question_dims(dimensions.begin(), dimensions.end());
+    dimension_set question_dims(dimensions.begin(), dimensions.end());
     std::vector<int> tuple_indices;
     if (id != -1) {
         // Add selected point first, then others
         tuple_indices.push_back(id);
-        for (int i = 0; i < S->numberOfPoints; ++i) {
-            if (S->points[i]->id != id) {
-                tuple_indices.push_back(S->points[i]->id);
+        for (point_t* point : points) {
+            if (point->id != id) {
+                tuple_indices.push_back(point->id);
             }
         }
     }
-    qm.questions[question_dims] = tuple_indices;
+    qm.record(question_dims, tuple_indices);
 }
 
-int ask_projected_question(point_set_t* skyline, point_t* u, const std::vector<int>& dimensions, int size, question_mapping& qm){
-    point_set_t* D = project_points(skyline, dimensions);
-    point_set_t* S = select_random_points(D, size);
-    point_t* u_hat = project_utility(u, dimensions);
-    int id = simulated_choice_id(S, u_hat);
+// the reasons a session can fail for, which snapshots store by index
+const char* const ERROR_NO_DIMENSIONS = "no_candidate_dimensions";
+const char* const ERROR_INTERNAL = "internal_error";
+const char* const SESSION_ERRORS[] = {ERROR_NO_DIMENSIONS, ERROR_INTERNAL};
+const int SESSION_ERROR_COUNT = sizeof(SESSION_ERRORS) / sizeof(SESSION_ERRORS[0]);
+
+bool valid_answer(const highdim_question& question, int answer){
+    if (question.dimension_question) return answer == 0 || answer == 1;
+    return answer >= (question.allow_none ? HIGHDIM_NO_CHOICE : 0) && answer < (int)question.points.size();
+}
 
-    record_question(qm, dimensions, S, id);
+} // namespace
+
+int simulated_answer(const highdim_question& question, point_t* u){
+    if (question.dimension_question) {
+        return u->coord[question.dimensions[0]] > 0 ? 1 : 0;
+    }
+    // the point of maximum utility on the shown dimensions; none if no point has positive utility
+    double maxValue = question.allow_none ? 0 : -1;
+    int maxIdx = HIGHDIM_NO_CHOICE;
+    for (int i = 0; i < question.points.size(); i++) {
+        double value = 0;
+        for (int dim : question.dimensions) {
+            value += u->coord[dim] * question.points[i]->coord[dim];
+        }
+        if (value > maxValue) {
+            maxValue = value;
+            maxIdx = i;
+        }
+    }
+    return maxIdx;
+}
 
-    release_point(u_hat);
-    release_point_set(S, false);
-    release_point_set(D, true);
+int ask_projected_question(point_set_t* skyline, point_t* u, const std::vector<int>& dimensions, int size, question_mapping& qm){
+    std::vector<int> positions = select_random_positions(skyline, size, experiment_random_generator());
+    highdim_question question = {false, dimensions, skyline_points(skyline, positions), true};
+    int answer = simulated_answer(question, u);
+    int id = answer == HIGHDIM_NO_CHOICE ? -1 : question.points[answer]->id;
+    record_question(qm, dimensions, question.points, id);
     return id;
 }
 
-std::set<int> combine_candidate_dimensions(const std::set<int>& final_dimensions, const std::set<int>& selected_dimensions, int d_bar){
-    std::set<int> set_final_dimensions;
-    if (selected_dimensions.size() == 0 || final_dimensions.size() == d_bar){
-        set_final_dimensions = final_dimensions;
-    }
-    else {
-        std::set_union(final_dimensions.begin(), final_dimensions.end(),
-            selected_dimensions.begin(), selected_dimensions.end(),
-            std::inserter(set_final_dimensions, set_final_dimensions.begin()));
+namespace {
+
+std::set<int> combine_candidate_dimensions(const dimension_set& final_dimensions, const dimension_set& selected_dimensions, int d_bar){
+    std::set<int> set_final_dimensions(final_dimensions.begin(), final_dimensions.end());
+    if (selected_dimensions.size() != 0 && final_dimensions.size() != d_bar){
+        set_final_dimensions.insert(selected_dimensions.begin(), selected_dimensions.end());
     }
     return set_final_dimensions;
 }
@@ -115,15 +127,21 @@ std::map<int, int> build_dimension_mapping(const std::set<int>& dimensions){
     return dim_mapping;
 }
 
-point_t* find_point_by_id(point_set_t* points, int id){
+int find_position_by_id(point_set_t* points, int id){
     for (int i = 0; i < points->numberOfPoints; ++i) {
         if (points->points[i]->id == id) {
-            return points->points[i];
+            return i;
         }
     }
-    return nullptr;
+    return -1;
 }
 
+point_t* find_point_by_id(point_set_t* points, int id){
+    int position = find_position_by_id(points, id);
+    return position == -1 ? nullptr : points->points[position];
+}
+
+// nullptr if a point of S is not in the skyline
 point_set_t* map_sphere_result_to_skyline(point_set_t* skyline, point_set_t* S){
     point_set_t* S_output = alloc_point_set(S->numberOfPoints);
     for (int i = 0; i < S->numberOfPoints; ++i){
@@ -131,8 +149,8 @@ point_set_t* map_sphere_result_to_skyline(point_set_t* skyline, point_set_t* S){
         int target_id = S->points[i]->id;
         point_t* matched_point = find_point_by_id(skyline, target_id);
         if (matched_point == nullptr) {
-            printf("Error: Could not find point in skyline with id %d\n", target_id);
-            exit(1);
+            release_point_set(S_output, false);
+            return nullptr;
         }
         S_output->points[i] = matched_point;
     }
@@ -141,263 +159,445 @@ point_set_t* map_sphere_result_to_skyline(point_set_t* skyline, point_set_t* S){
 
 } // namespace
 
-highdim_output* interactive_highdim(point_set_t* skyline, int size, int d_bar, int d_hat, int d_hat_2, point_t* u, int K, int s, double epsilon, int maxRound, double& Qcount, double& Csize, int cmp_option, int stop_option, int prune_option, int dom_option, int& num_questions){
+highdim_projection::highdim_projection(point_set_t* source, const std::vector<int>& dimensions)
+    : points(project_points(source, dimensions)), skyline(skyline_point(points)) {}
 
-    int n = skyline->numberOfPoints;
-    int d = skyline->points[0]->dim;
-    // record the time for phase 1 and 2
-    double time_12 = 0.0;
-    auto start_time_12 = std::chrono::high_resolution_clock::now();
-    
-    // Initialize question mapping to record all questions asked
-    question_mapping qm;
-    
-    // phase 1: narrow down the dimensions
-    // printf("Phase 1\n"); // 111
-	// store the dimensions if the user is interested in at least one in the set
-	std::set<int> selected_dimensions;
-    for (int i = 0; i < d; ++i) selected_dimensions.insert(i); // initial all dimensions
+highdim_projection::~highdim_projection(){
+    release_point_set(skyline, false);
+    release_point_set(points, true);
+}
 
-    // Keep the original full-block behavior; tail dimensions remain selected when d is not divisible by d_hat.
-	for (int i=0;i<d/d_hat;++i){
-        // first check if the user is willing to answer questions
-        if (num_questions <= 0){
-            break; // no more questions left
+highdim_projection_cache::highdim_projection_cache(point_set_t* skyline, int capacity)
+    : skyline_(skyline), capacity_(capacity < 1 ? 1 : capacity) {}
+
+std::shared_ptr<highdim_projection> highdim_projection_cache::get(const std::vector<int>& dimensions){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it){
+            if (it->first == dimensions){
+                entries_.splice(entries_.begin(), entries_, it);
+                return entries_.front().second;
+            }
         }
-		//Restrict D to dimensions i*d_hat, i*d_hat+1, ..., i*d_hat+d_hat-1
-        std::vector<int> dimensions = dimension_range(i*d_hat, d_hat);
-        int id = ask_projected_question(skyline, u, dimensions, size, qm);
-        num_questions -= 1;
-        
-		if (id==-1){
-			// for (int j=0;j<d_hat;++j) selected_dimensions.erase(i*d_hat+j);
-            for (int j=0;j<d_hat;++j){
-                int dim_to_remove = i*d_hat+j;
-                selected_dimensions.erase(dim_to_remove);
+    }
+    // project without the lock, so that other sessions keep using the cache meanwhile
+    std::shared_ptr<highdim_projection> projection = std::make_shared<highdim_projection>(skyline_, dimensions);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_){
+        if (entry.first == dimensions) return entry.second; // projected concurrently by another session
+    }
+    entries_.emplace_front(dimensions, projection);
+    // sessions still holding an evicted projection keep it alive
+    if (entries_.size() > capacity_) entries_.pop_back();
+    return projection;
+}
+
+highdim_session::highdim_session(point_set_t* skyline, const highdim_parameters& parameters, const highdim_random& random,
+        highdim_projection_cache* projections)
+    : skyline_(skyline), parameters_(parameters), random_(random), phase_(PHASE_1), remaining_(parameters.num_questions),
+      has_question_(false), kind_(BLOCK_QUESTION), block_(0), d_left_(0), d_target_(parameters.d_bar), step_(STEP_OUTER),
+      small_index_(0), group_size_(0), left_(0), right_(0), projections_(projections), D_prime_(nullptr), skyline_D_prime_(nullptr),
+      candidate_size_(0){
+    state_.current_best_idx = -1;
+    state_.last_best = -1;
+    state_.rr = 1;
+    state_.rounds = 0;
+    output_.S = nullptr;
+    output_.time_12 = 0;
+    output_.time_3 = 0;
+    output_.error = nullptr;
+    for (int i = 0; i < METRIC_TIMER_COUNT; ++i) seconds_[i] = 0;
+    // store the dimensions if the user is interested in at least one in the set
+    selected_dimensions_ = dimension_set::range(0, skyline->points[0]->dim); // initial all dimensions
+}
+
+highdim_session::~highdim_session(){
+    for (point_t* e : state_.ext_vec) release_point(e);
+    release_conical_hull_cache(state_.conical);
+    if (output_.S != nullptr) release_point_set(output_.S, false);
+}
+
+const highdim_question* highdim_session::next_question(){
+    if (!has_question_ && phase_ != PHASE_FINISHED) {
+        mark_ = std::chrono::steady_clock::now();
+        advance();
+    }
+    return has_question_ ? &question_ : nullptr;
+}
+
+bool highdim_session::submit_answer(int answer){
+    if (!has_question_ || !valid_answer(question_, answer)) return false;
+    mark_ = std::chrono::steady_clock::now();
+    has_question_ = false;
+    batch_.clear();
+    apply_answer(answer);
+    advance();
+    return true;
+}
+
+const std::vector<highdim_question>& highdim_session::next_questions(int limit){
+    batch_.clear();
+    if (next_question() == nullptr || limit < 1) return batch_;
+    batch_.push_back(question_);
+    if (kind_ != BLOCK_QUESTION) return batch_;
+    mark_ = std::chrono::steady_clock::now();
+    // draw the points of the following blocks as advance will, from a copy of the generator; phase 1 stops at the
+    // last full block or when the budget is spent, whatever the answers
+    std::mt19937 points = random_.points;
+    int d = skyline_->points[0]->dim;
+    int d_hat = parameters_.d_hat;
+    for (int block = block_ + 1; block < d/d_hat && (int)batch_.size() < std::min(limit, remaining_); ++block) {
+        highdim_question question;
+        question.dimension_question = false;
+        question.dimensions = dimension_range(block*d_hat, d_hat);
+        question.points = skyline_points(skyline_, select_random_positions(skyline_, parameters_.size, points));
+        question.allow_none = true;
+        batch_.push_back(question);
+    }
+    charge(METRIC_TIME_PHASE_1);
+    return batch_;
+}
+
+bool highdim_session::submit_answers(const std::vector<int>& answers){
+    if (answers.empty() || answers.size() > batch_.size()) return false;
+    for (size_t i = 0; i < answers.size(); ++i) {
+        if (!valid_answer(batch_[i], answers[i])) return false;
+    }
+    // each answer leaves the next question of the batch pending
+    for (int answer : answers) submit_answer(answer);
+    return true;
+}
+
+metric_timer highdim_session::phase_timer() const{
+    if (phase_ == PHASE_1) return METRIC_TIME_PHASE_1;
+    if (phase_ == PHASE_2) return METRIC_TIME_PHASE_2;
+    return METRIC_TIME_PHASE_3;
+}
+
+void highdim_session::charge(metric_timer timer){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    seconds_[timer] += std::chrono::duration<double>(now - mark_).count();
+    mark_ = now;
+}
+
+// compute until the next question is pending or the session is finished
+void highdim_session::advance(){
+    if (phase_ == PHASE_1) {
+        if (phase_1_question()) {
+            charge(METRIC_TIME_PHASE_1);
+            return;
+        }
+        charge(METRIC_TIME_PHASE_1);
+        phase_ = PHASE_2;
+        d_left_ = selected_dimensions_.size();
+        // the user is interested in no block, and no dimension is left after the last full block
+        if (d_left_ == 0) fail(ERROR_NO_DIMENSIONS);
+    }
+    if (phase_ == PHASE_2) {
+        if (phase_2_question()) {
+            charge(METRIC_TIME_PHASE_2);
+            return;
+        }
+        charge(METRIC_TIME_PHASE_2);
+        if (phase_ == PHASE_2) start_phase_3();
+    }
+    if (phase_ == PHASE_3) {
+        ensure_phase_3_projection();
+        bool asked = phase_3_question();
+        charge(METRIC_TIME_PHASE_3);
+        if (!asked) {
+            double Csize = 0;
+            point_t* opt_p = max_utility_finish(skyline_D_prime_, state_, Csize, parameters_.dom_option);
+            candidate_size_ = Csize;
+            // Find the point in skyline that matches the id of opt_p
+            point_t* matched_point = find_point_by_id(skyline_, opt_p->id);
+            if (matched_point == nullptr) {
+                fail(ERROR_INTERNAL);
+                return;
             }
-		}
-	}
-	// phase 2: narrow down the at most d_hat*d' dimensions further
-    // printf("Phase 2\n"); // 222
-	// apply the Generalized_binary-splitting_algorithm
-	// store the dimensions the user is interested in
-	set<int> final_dimensions;
-	int d_left = selected_dimensions.size();
-    // for debugging purpose
-    if (d_left == 0){
-        printf("error_1: d_left is 0\n");
-        exit(1);
-    }
-    int d_target = d_bar;
-	while (d_left > 0 && num_questions > 0 && final_dimensions.size() < d_bar){
-        d_left = selected_dimensions.size();
-		if (d_left <= 2*d_target-2){
-			for (int i=0;i<d_left;++i){
-				// insert interaction
-				// show the user the dimension, ask if interested in
-				// bool answer = false; //user's answer
-                // for the purpose of testing, we will use the utility vector u to select the answer
-                // extract the first dimension in selected_dimensions
-                // for debugging purpose
-                if (selected_dimensions.size() == 0){
-                    printf("error_2: selected_dimensions is empty\n");
-                    exit(1);
+            point_set_t* S_output = alloc_point_set(1);
+            S_output->points[0] = matched_point;
+            finish(S_output);
+        }
+    }
+}
+
+void highdim_session::ask_points(const std::vector<int>& dimensions, question_kind kind){
+    question_.dimension_question = false;
+    question_.dimensions = dimensions;
+    positions_ = select_random_positions(skyline_, parameters_.size, random_.points);
+    question_.points = skyline_points(skyline_, positions_);
+    question_.allow_none = true;
+    kind_ = kind;
+    has_question_ = true;
+}
+
+void highdim_session::ask_dimension(int dimension, question_kind kind){
+    question_.dimension_question = true;
+    question_.dimensions.assign(1, dimension);
+    question_.points.clear();
+    positions_.clear();
+    question_.allow_none = false;
+    kind_ = kind;
+    has_question_ = true;
+}
+
+// record an answered projected question for phase 3
+void highdim_session::record(int answer){
+    int id = answer == HIGHDIM_NO_CHOICE ? -1 : question_.points[answer]->id;
+    record_question(qm_, question_.dimensions, question_.points, id);
+}
+
+// phase 1: narrow down the dimensions
+bool highdim_session::phase_1_question(){
+    // Keep the original full-block behavior; tail dimensions remain selected when d is not divisible by d_hat.
+    int d = skyline_->points[0]->dim;
+    int d_hat = parameters_.d_hat;
+    // first check if the user is willing to answer questions
+    if (block_ >= d/d_hat || remaining_ <= 0) return false;
+    //Restrict D to dimensions i*d_hat, i*d_hat+1, ..., i*d_hat+d_hat-1
+    ask_points(dimension_range(block_*d_hat, d_hat), BLOCK_QUESTION);
+    return true;
+}
+
+// phase 2: narrow down the at most d_hat*d' dimensions further
+// apply the Generalized_binary-splitting_algorithm, asking one question per call
+bool highdim_session::phase_2_question(){
+    while (true) {
+        if (step_ == STEP_DONE) return false;
+        if (step_ == STEP_SMALL) {
+            if (small_index_ < d_left_) {
+                // show the user the dimension, ask if interested in
+                if (selected_dimensions_.size() == 0){
+                    fail(ERROR_INTERNAL);
+                    return false;
                 }
-                int current_dim = *selected_dimensions.begin();
-                bool answer = u->coord[current_dim] > 0;
-                num_questions -= 1;
-				if (!answer){
-					selected_dimensions.erase(selected_dimensions.begin());
-                    d_left -= 1;
-				}
-				else {
-					final_dimensions.insert(current_dim);
-					selected_dimensions.erase(selected_dimensions.begin());
-                    d_left -= 1;
-                    d_target -= 1;
-
-				}
-			}
-			// break; // unnecessary
-		}
-		else {
-			int l = d_left - d_target + 1;
-            int alpha = floor(log2(double(l)/d_target));
-            int group_size = pow(2, alpha);
-            // for debugging purpose
-            if (group_size == 0){
-                printf("error_3: group_size is 0\n");
-                exit(1);
+                ask_dimension(selected_dimensions_.select(0), SMALL_QUESTION);
+                return true;
             }
-            if (group_size > d_left){
-                printf("error_4: group_size is greater than d_left\n");
-                exit(1);
+            step_ = STEP_OUTER;
+        }
+        if (step_ == STEP_SEARCH) {
+            // do a binary search to find one dimension
+            if (left_ < right_ && remaining_ > 0) {
+                int mid = left_ + (right_ - left_) / 2;
+                if (mid == left_) {
+                    // check whether the dimension is in the left half or the right half
+                    ask_dimension(selected_dimensions_.select(left_), SEARCH_DIMENSION_QUESTION);
+                }
+                else {
+                    ask_points(selected_dimensions_.slice(left_, mid - left_ + 1), SEARCH_GROUP_QUESTION);
+                }
+                return true;
             }
-            int id;
-            if (group_size == 1){
-                id = u->coord[*selected_dimensions.begin()] > 0 ? skyline->points[0]->id : -1;
-                num_questions -= 1;
+            step_ = STEP_OUTER;
+        }
+        if (!(d_left_ > 0 && remaining_ > 0 && final_dimensions_.size() < parameters_.d_bar && !cancellation_requested())) {
+            return false;
+        }
+        d_left_ = selected_dimensions_.size();
+        if (d_left_ <= 2*d_target_-2) {
+            small_index_ = 0;
+            step_ = STEP_SMALL;
+            continue;
+        }
+        int l = d_left_ - d_target_ + 1;
+        int alpha = floor(log2(double(l)/d_target_));
+        group_size_ = pow(2, alpha);
+        if (group_size_ == 0 || group_size_ > d_left_){
+            fail(ERROR_INTERNAL);
+            return false;
+        }
+        if (group_size_ == 1) {
+            ask_dimension(selected_dimensions_.select(0), GROUP_QUESTION);
+        }
+        else {
+            // select the first size dimensions
+            ask_points(selected_dimensions_.slice(0, group_size_), GROUP_QUESTION);
+        }
+        return true;
+    }
+}
+
+void highdim_session::apply_answer(int answer){
+    remaining_ -= 1;
+    // the user is interested in the dimension, or in one of the points shown
+    bool interested = question_.dimension_question ? answer == 1 : answer != HIGHDIM_NO_CHOICE;
+    switch (kind_) {
+    case BLOCK_QUESTION:
+        record(answer);
+        if (!interested) {
+            for (int j = 0; j < parameters_.d_hat; ++j) selected_dimensions_.erase(block_*parameters_.d_hat + j);
+        }
+        block_++;
+        break;
+    case SMALL_QUESTION: {
+        int current_dim = selected_dimensions_.select(0);
+        if (interested) {
+            final_dimensions_.insert(current_dim);
+            d_target_ -= 1;
+        }
+        selected_dimensions_.erase(current_dim);
+        d_left_ -= 1;
+        small_index_++;
+        break;
+    }
+    case GROUP_QUESTION:
+        if (!question_.dimension_question) record(answer);
+        if (!interested) {
+            for (int dim : selected_dimensions_.slice(0, group_size_)) selected_dimensions_.erase(dim);
+            d_left_ -= group_size_;
+            step_ = STEP_OUTER;
+        }
+        // check if the user is willing to answer more questions
+        else if (remaining_ <= 0) {
+            step_ = STEP_DONE;
+        }
+        else if (group_size_ == 1) {
+            int current_dim = selected_dimensions_.select(0);
+            final_dimensions_.insert(current_dim);
+            selected_dimensions_.erase(current_dim);
+            d_left_ -= 1;
+            d_target_ -= 1;
+            step_ = STEP_OUTER;
+        }
+        else {
+            left_ = 0;
+            right_ = group_size_ - 1;
+            step_ = STEP_SEARCH;
+        }
+        break;
+    case SEARCH_DIMENSION_QUESTION: {
+        // found the dimension in the left half (mid == left), otherwise it is the right one
+        int found = selected_dimensions_.select(interested ? left_ : right_);
+        final_dimensions_.insert(found);
+        selected_dimensions_.erase(found);
+        d_left_ -= 1;
+        d_target_ -= 1;
+        step_ = STEP_OUTER;
+        break;
+    }
+    case SEARCH_GROUP_QUESTION: {
+        record(answer);
+        int mid = left_ + (right_ - left_) / 2;
+        if (!interested) {
+            // the dimension is in the right half, remove all dimensions in the left half
+            for (int dim : selected_dimensions_.slice(left_, mid - left_ + 1)) {
+                selected_dimensions_.erase(dim);
+                d_left_ -= 1;
             }
-            else {
-                // select the first size dimensions
-                std::vector<int> dimensions = selected_dimension_slice(selected_dimensions, 0, group_size);
-                id = ask_projected_question(skyline, u, dimensions, size, qm);
-                num_questions -= 1;
+            right_ = right_ - mid + left_ - 1; // adjust the right pointer (since we are now operating a set)
+        }
+        else {
+            // the dimension is in the left half, however cannot remove dimensions in the right half
+            if (right_ == mid){
+                fail(ERROR_INTERNAL);
+                break;
             }
-			if (id == -1){
-				for (int j=0;j<group_size;++j){
-					int dim_to_remove = *selected_dimensions.begin();
-					selected_dimensions.erase(selected_dimensions.begin());
-				}
-				d_left -= group_size;
-				continue;
-			}
-			else {
-                // check if the user is willing to answer more questions
-                if (num_questions <= 0) break;
-                if (group_size == 1){
-                    final_dimensions.insert(*selected_dimensions.begin());
-                    selected_dimensions.erase(selected_dimensions.begin());
-                    d_left -= 1;
-                    d_target -= 1;
-                }
-                else{
-                    // do a binary search to find one dimension
-                    int left = 0;
-                    int right = group_size-1;
-                    while (left < right && num_questions > 0){
-                        int mid = left + (right - left) / 2;
-                        if (mid == left){
-                            if (right == left){
-                                // one dimension has been found
-                                final_dimensions.insert(*next(selected_dimensions.begin(), mid));
-                                selected_dimensions.erase(next(selected_dimensions.begin(), mid));
-                                d_left -= 1;
-                                d_target -= 1;
-                                break;
-                            }
-                            else {
-                                // check whether the dimension is in the left half or the right half
-                                if (u->coord[*next(selected_dimensions.begin(), left)] > 0){
-                                    num_questions -= 1;
-                                    // found the dimension
-                                    final_dimensions.insert(*next(selected_dimensions.begin(), mid));
-                                    selected_dimensions.erase(next(selected_dimensions.begin(), mid));
-                                    d_left -= 1;
-                                    d_target -= 1;
-                                }
-                                // if (u->coord[*next(selected_dimensions.begin(), right)] > 0){
-                                else{
-                                    num_questions -= 1;
-                                    // the dimension is in the right half
-                                    final_dimensions.insert(*next(selected_dimensions.begin(), right));
-                                    selected_dimensions.erase(next(selected_dimensions.begin(), right));
-                                    d_left -= 1;
-                                    d_target -= 1;
-                                }
-                                break;
-                            }
-                        }
-                        std::vector<int> dimensions = selected_dimension_slice(selected_dimensions, left, mid - left + 1);
-                        int id = ask_projected_question(skyline, u, dimensions, size, qm);
-                        num_questions -= 1;
-                        
-                        if (id == -1){
-                            // the dimension is in the right half, remove all dimensions in the left half
-                            for (int j=0; j < mid-left+1; ++j){
-                                int dim_to_remove = *next(selected_dimensions.begin(), left);
-                                selected_dimensions.erase(next(selected_dimensions.begin(), left));
-                                d_left -= 1;
-                            }
-                            // left = mid+1;
-                            right = right - mid + left - 1; // adjust the right pointer (since we are now operating a set)
-                        }
-                        else {
-                            // the dimension is in the left half, however cannot remove dimensions in the right half
-                            // for debugging purpose
-                            if (right == mid){
-                                printf("error_5: right == mid\n");
-                                exit(1);
-                            }
-                            right = mid;
-                        }
-                    }
-                }
-			}
-		}
-	}
-    auto end_time_12 = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration_12 = end_time_12 - start_time_12;
-    time_12 = duration_12.count();
-	// phase 3: find the optimal tuple or the optimal subset
-    // printf("Phase 3\n"); // 444
-	// take the union of the final_dimensions and the selected_dimensions
-	std::set<int> set_final_dimensions = combine_candidate_dimensions(final_dimensions, selected_dimensions, d_bar);
-	// construct the final subset
-	point_set_t* S_output = nullptr;
-
-	int final_d = set_final_dimensions.size();
-    printf("number of dimensions left in Candidate Set: %d\n", final_d);
-    std::vector<int> final_dimension_list(set_final_dimensions.begin(), set_final_dimensions.end());
-	point_set_t* D_prime = project_points(skyline, final_dimension_list);
+            right_ = mid;
+        }
+        break;
+    }
+    case PHASE_3_QUESTION:
+        ensure_phase_3_projection();
+        max_utility_submit(skyline_D_prime_, state_, answer, parameters_.stop_option, parameters_.prune_option, parameters_.dom_option);
+        break;
+    }
+}
 
-    // take the skyline of the newly constructed dataset D_prime
-    point_set_t* skyline_D_prime = skyline_point(D_prime);
+// the skyline projected onto the candidate dimensions; restore builds it for a session in phase 3
+void highdim_session::ensure_phase_3_projection(){
+    if (projection_) return;
+    // take the skyline of the dataset D_prime projected onto the final dimensions
+    projection_ = projections_ != nullptr ? projections_->get(final_dimension_list_)
+        : std::make_shared<highdim_projection>(skyline_, final_dimension_list_);
+    D_prime_ = projection_->points;
+    skyline_D_prime_ = projection_->skyline;
+}
 
+// phase 3: find the optimal tuple or the optimal subset
+void highdim_session::start_phase_3(){
+    // take the union of the final_dimensions and the selected_dimensions
+    set_final_dimensions_ = combine_candidate_dimensions(final_dimensions_, selected_dimensions_, parameters_.d_bar);
+    int final_d = set_final_dimensions_.size();
+    printf("number of dimensions left in Candidate Set: %d\n", final_d);
+    // the user declined every dimension of phase 2
+    if (final_d == 0) {
+        fail(ERROR_NO_DIMENSIONS);
+        return;
+    }
+    final_dimension_list_.assign(set_final_dimensions_.begin(), set_final_dimensions_.end());
+    ensure_phase_3_projection();
+    charge(METRIC_TIME_PHASE_3_PREPARE);
+    phase_ = PHASE_3;
 
-    // printf("number of points in skyline_D: %d\n", skyline_D_prime->numberOfPoints);
-    // construct the final u
-    point_t* u_final = project_utility(u, final_dimension_list);
+    if (final_d == 1) {
+        // a single dimension orders the points, so its best point is the best point of the user
+        int dim = final_dimension_list_[0];
+        point_set_t* S_output = alloc_point_set(1);
+        S_output->points[0] = skyline_->points[0];
+        for (int i = 1; i < skyline_->numberOfPoints; ++i) {
+            if (skyline_->points[i]->coord[dim] > S_output->points[0]->coord[dim]) S_output->points[0] = skyline_->points[i];
+        }
+        finish(S_output);
+        return;
+    }
 
-    double time_3 = 0.0;
-    auto start_time_3 = std::chrono::high_resolution_clock::now();
-	if (num_questions > 0){
-		// apply the interactive code to select the optimal tuple
-        // printf("Applying the interactive algorithm to select the optimal tuple\n");
-        S_output = alloc_point_set(1);
-        // if (skyline_D_prime->points[0]->dim == final_d) printf("dimension: %d\n", final_d);
-        
+    if (remaining_ > 0) {
+        // apply the interactive code to select the optimal tuple, starting from the recorded questions
         // Create a mapping from original dimensions to reduced dimensions
-        std::map<int, int> dim_mapping = build_dimension_mapping(set_final_dimensions);
-        
-        // Use max_utility_with_questions instead of max_utility to incorporate pre-recorded questions
-        point_t* opt_p = max_utility_with_questions(skyline_D_prime, u_final, s, epsilon, num_questions, Qcount, Csize, cmp_option, stop_option, prune_option, dom_option, qm, dim_mapping, D_prime);
-        // Find the point in skyline that matches the id of opt_p
-        point_t* matched_point = find_point_by_id(skyline, opt_p->id);
-        if (matched_point == nullptr) {
-            printf("Error: Could not find point in skyline with id %d\n", opt_p->id);
-            exit(1);
-        }
-        S_output->points[0] = matched_point;
-        num_questions -= Qcount;
-    }
-	else {
-        // if (final_d >= K){
-        //     // exit
-        //     printf("error: final_d >= K\n");
-        //     exit(1);
-        // }
-        // printf("Applying the attribute subset method to output a regret minimizing subset\n");
-        if (final_d <= d_hat_2){
-            point_set_t* S = sphereWSImpLP(skyline_D_prime, K);
-            S_output = map_sphere_result_to_skyline(skyline, S);
-            release_point_set(S, false);
-        }
-        else {
-            S_output = attribute_subset(skyline, S_output, final_d, d_hat_2, K, set_final_dimensions);
+        std::map<int, int> dim_mapping = build_dimension_mapping(set_final_dimensions_);
+        // the dimensions the user declared interest in
+        std::set<int> key_dims;
+        for (int dim : final_dimensions_) key_dims.insert(dim_mapping[dim]);
+        max_utility_begin(skyline_D_prime_, state_, qm_, key_dims, dim_mapping, D_prime_, parameters_.dom_option);
+        return;
+    }
+
+    // apply the attribute subset method to output a regret minimizing subset
+    point_set_t* S_output = nullptr;
+    if (final_d <= parameters_.d_hat_2){
+        point_set_t* S = sphereWSImpLP(skyline_D_prime_, parameters_.K);
+        S_output = map_sphere_result_to_skyline(skyline_, S);
+        release_point_set(S, false);
+        if (S_output == nullptr) {
+            fail(ERROR_INTERNAL);
+            return;
         }
-	}
+    }
+    else {
+        S_output = attribute_subset(skyline_, S_output, final_d, parameters_.d_hat_2, parameters_.K, set_final_dimensions_, random_.points);
+    }
+    finish(S_output);
+}
 
-    auto end_time_3 = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration_3 = end_time_3 - start_time_3;
-    time_3 = duration_3.count();
-    
+bool highdim_session::phase_3_question(){
+    // the questions left at the start of phase 3 bound its rounds
+    if (!max_utility_next(skyline_D_prime_, state_, parameters_.s, parameters_.epsilon, state_.rounds + remaining_, parameters_.cmp_option, random_.options,
+            &projection_->frames)) {
+        return false;
+    }
+    question_.dimension_question = false;
+    question_.dimensions = final_dimension_list_;
+    positions_.clear();
+    for (int i : state_.S) {
+        positions_.push_back(find_position_by_id(skyline_, skyline_D_prime_->points[state_.C_idx[i]]->id));
+    }
+    question_.points = skyline_points(skyline_, positions_);
+    question_.allow_none = false;
+    kind_ = PHASE_3_QUESTION;
+    has_question_ = true;
+    return true;
+}
+
+void highdim_session::finish(point_set_t* S_output){
+    charge(phase_timer());
     // Safety check: ensure S_output is not null
     if (S_output == nullptr) {
         printf("Error: S_output is null, creating empty point set\n");
         S_output = alloc_point_set(0);
     }
-    
+
     // Remove any null points from S_output
     point_set_t* cleaned_S_output = remove_null_points(S_output);
     if (cleaned_S_output != S_output) {
@@ -405,16 +605,337 @@ highdim_output* interactive_highdim(point_set_t* skyline, int size, int d_bar, i
         release_point_set(S_output, false);
         S_output = cleaned_S_output;
     }
-    
+
     //also return the information about the dimensions chosen, as stored in set_final_dimensions
-    highdim_output* output = new highdim_output;
-    output->S = S_output;
-    output->final_dimensions = set_final_dimensions;
-    output->time_12 = time_12;
-    output->time_3 = time_3;
+    output_.S = S_output;
+    output_.final_dimensions = set_final_dimensions_;
+    output_.time_12 = seconds_[METRIC_TIME_PHASE_1] + seconds_[METRIC_TIME_PHASE_2];
+    output_.time_3 = seconds_[METRIC_TIME_PHASE_3];
+    phase_ = PHASE_FINISHED;
+
     // release the memory
-    release_point_set(skyline_D_prime, false);
-    release_point_set(D_prime, true);
-    release_point(u_final);
+    projection_.reset();
+    skyline_D_prime_ = nullptr;
+    D_prime_ = nullptr;
+}
+
+// end the session without an output set
+void highdim_session::fail(const char* reason){
+    has_question_ = false;
+    output_.error = reason;
+    finish(alloc_point_set(0));
+}
+
+namespace {
+
+// leading bytes of a session snapshot, with the format version
+const char SNAPSHOT_MAGIC[4] = {'H', 'D', 'S', 2};
+
+// numbers and generators are stored in their memory representation
+static_assert(std::is_trivially_copyable<std::mt19937>::value, "the generators are stored as bytes");
+
+class snapshot_writer{
+public:
+    void put_bytes(const void* bytes, size_t size){ data_.append(static_cast<const char*>(bytes), size); }
+    void put_int(int value){ int32_t v = value; put_bytes(&v, sizeof(v)); }
+    void put_double(double value){ put_bytes(&value, sizeof(value)); }
+    void put_ints(const std::vector<int>& values){
+        put_int(values.size());
+        for (int value : values) put_int(value);
+    }
+    void put_set(const std::set<int>& values){ put_ints(std::vector<int>(values.begin(), values.end())); }
+    void put_dimensions(const dimension_set& values){ put_ints(std::vector<int>(values.begin(), values.end())); }
+    void put_generator(const std::mt19937& generator){ put_bytes(&generator, sizeof(generator)); }
+    const std::string& data() const { return data_; }
+
+private:
+    std::string data_;
+};
+
+// reads what snapshot_writer wrote; ok() turns false on the first read past the end
+class snapshot_reader{
+public:
+    explicit snapshot_reader(const std::string& data) : data_(data), position_(0), ok_(true) {}
+    bool get_bytes(void* bytes, size_t size){
+        if (!ok_ || data_.size() - position_ < size) return ok_ = false;
+        memcpy(bytes, data_.data() + position_, size);
+        position_ += size;
+        return true;
+    }
+    int get_int(){ int32_t v = 0; get_bytes(&v, sizeof(v)); return v; }
+    double get_double(){ double v = 0; get_bytes(&v, sizeof(v)); return v; }
+    std::vector<int> get_ints(){
+        int count = get_int();
+        std::vector<int> values;
+        if (count < 0 || count > (data_.size() - position_) / sizeof(int32_t)) {
+            ok_ = false;
+            return values;
+        }
+        for (int i = 0; i < count; ++i) values.push_back(get_int());
+        return values;
+    }
+    std::set<int> get_set(){
+        std::vector<int> values = get_ints();
+        return std::set<int>(values.begin(), values.end());
+    }
+    // dimensions outside [0, d) fail the read
+    dimension_set get_dimensions(int d){
+        std::vector<int> values = get_ints();
+        for (int value : values) {
+            if (value < 0 || value >= d) {
+                ok_ = false;
+                return dimension_set();
+            }
+        }
+        return dimension_set(values.begin(), values.end());
+    }
+    void get_generator(std::mt19937& generator){ get_bytes(&generator, sizeof(generator)); }
+    void fail(){ ok_ = false; }
+    bool ok() const { return ok_; }
+    bool at_end() const { return position_ == data_.size(); }
+
+private:
+    const std::string& data_;
+    size_t position_;
+    bool ok_;
+};
+
+bool valid_positions(const std::vector<int>& positions, int count){
+    for (int position : positions) {
+        if (position < 0 || position >= count) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string highdim_session::snapshot() const{
+    snapshot_writer out;
+    out.put_bytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.put_int(skyline_->numberOfPoints);
+    out.put_int(skyline_->points[0]->dim);
+
+    const highdim_parameters& p = parameters_;
+    for (int value : {p.size, p.d_bar, p.d_hat, p.d_hat_2, p.K, p.s, p.cmp_option, p.stop_option, p.prune_option, p.dom_option, p.num_questions}) {
+        out.put_int(value);
+    }
+    out.put_double(p.epsilon);
+    out.put_generator(random_.points);
+    out.put_generator(random_.options);
+
+    out.put_int(phase_);
+    out.put_int(remaining_);
+    out.put_int(qm_.questions.size());
+    for (const auto& question : qm_.questions) {
+        out.put_dimensions(question.first);
+        out.put_ints(question.second);
+    }
+
+    out.put_int(has_question_);
+    out.put_int(kind_);
+    out.put_int(question_.dimension_question);
+    out.put_ints(question_.dimensions);
+    out.put_ints(positions_);
+    out.put_int(question_.allow_none);
+
+    for (int value : {block_, d_left_, d_target_, (int)step_, small_index_, group_size_, left_, right_}) {
+        out.put_int(value);
+    }
+    out.put_dimensions(selected_dimensions_);
+    out.put_dimensions(final_dimensions_);
+    out.put_set(set_final_dimensions_);
+
+    out.put_ints(state_.C_idx);
+    out.put_int(state_.ext_vec.size());
+    for (point_t* e : state_.ext_vec) {
+        out.put_int(e->dim);
+        for (int i = 0; i < e->dim; ++i) out.put_double(e->coord[i]);
+    }
+    out.put_int(state_.current_best_idx);
+    out.put_int(state_.last_best);
+    out.put_ints(state_.frame);
+    out.put_double(state_.rr);
+    out.put_int(state_.rounds);
+    out.put_ints(state_.S);
+    out.put_int(candidate_size_);
+
+    // the output points are kept by id
+    std::vector<int> output_ids;
+    if (output_.S != nullptr) {
+        for (int i = 0; i < output_.S->numberOfPoints; ++i) output_ids.push_back(output_.S->points[i]->id);
+    }
+    out.put_int(output_.S != nullptr);
+    out.put_ints(output_ids);
+    out.put_set(output_.final_dimensions);
+    out.put_double(output_.time_12);
+    out.put_double(output_.time_3);
+    int error = -1;
+    for (int i = 0; i < SESSION_ERROR_COUNT; ++i) {
+        if (output_.error == SESSION_ERRORS[i]) error = i;
+    }
+    out.put_int(error);
+    for (int i = 0; i < METRIC_TIMER_COUNT; ++i) out.put_double(seconds_[i]);
+    return out.data();
+}
+
+// the session of a snapshot, with the indexes into its phase 3 projection not checked
+highdim_session* highdim_session::read_snapshot(point_set_t* skyline, const std::string& blob, highdim_projection_cache* projections){
+    snapshot_reader in(blob);
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!in.get_bytes(magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) return nullptr;
+    int n = skyline->numberOfPoints;
+    int d = skyline->points[0]->dim;
+    if (in.get_int() != n || in.get_int() != d) return nullptr;
+
+    highdim_parameters p;
+    for (int* value : {&p.size, &p.d_bar, &p.d_hat, &p.d_hat_2, &p.K, &p.s, &p.cmp_option, &p.stop_option, &p.prune_option, &p.dom_option, &p.num_questions}) {
+        *value = in.get_int();
+    }
+    p.epsilon = in.get_double();
+    highdim_random random;
+    in.get_generator(random.points);
+    in.get_generator(random.options);
+    if (!in.ok() || p.d_hat <= 0) return nullptr;
+
+    highdim_session* session = new highdim_session(skyline, p, random, projections);
+    int phase = in.get_int();
+    session->remaining_ = in.get_int();
+    int questions = in.get_int();
+    for (int i = 0; i < questions && in.ok(); ++i) {
+        dimension_set dimensions = in.get_dimensions(d);
+        session->qm_.record(dimensions, in.get_ints());
+    }
+
+    session->has_question_ = in.get_int() != 0;
+    int kind = in.get_int();
+    session->question_.dimension_question = in.get_int() != 0;
+    session->question_.dimensions = in.get_ints();
+    session->positions_ = in.get_ints();
+    session->question_.allow_none = in.get_int() != 0;
+
+    session->block_ = in.get_int();
+    session->d_left_ = in.get_int();
+    session->d_target_ = in.get_int();
+    int step = in.get_int();
+    session->small_index_ = in.get_int();
+    session->group_size_ = in.get_int();
+    session->left_ = in.get_int();
+    session->right_ = in.get_int();
+    session->selected_dimensions_ = in.get_dimensions(d);
+    session->final_dimensions_ = in.get_dimensions(d);
+    session->set_final_dimensions_ = in.get_set();
+    session->final_dimension_list_.assign(session->set_final_dimensions_.begin(), session->set_final_dimensions_.end());
+
+    max_utility_state& state = session->state_;
+    state.C_idx = in.get_ints();
+    int ext_count = in.get_int();
+    for (int i = 0; i < ext_count && in.ok(); ++i) {
+        int dim = in.get_int();
+        if (dim != (int)session->final_dimension_list_.size()) {
+            in.fail(); // the extreme vectors live in the space of the candidate dimensions
+            break;
+        }
+        point_t* e = alloc_point(dim);
+        for (int j = 0; j < dim; ++j) e->coord[j] = in.get_double();
+        state.ext_vec.push_back(e);
+    }
+    state.current_best_idx = in.get_int();
+    state.last_best = in.get_int();
+    state.frame = in.get_ints();
+    state.rr = in.get_double();
+    state.rounds = in.get_int();
+    state.S = in.get_ints();
+    session->candidate_size_ = in.get_int();
+
+    bool has_output = in.get_int() != 0;
+    std::vector<int> output_ids = in.get_ints();
+    session->output_.final_dimensions = in.get_set();
+    session->output_.time_12 = in.get_double();
+    session->output_.time_3 = in.get_double();
+    int error = in.get_int();
+    for (int i = 0; i < METRIC_TIMER_COUNT; ++i) session->seconds_[i] = in.get_double();
+
+    bool valid = in.ok() && in.at_end()
+        && phase >= PHASE_1 && phase <= PHASE_FINISHED && kind >= BLOCK_QUESTION && kind <= PHASE_3_QUESTION
+        && step >= STEP_OUTER && step <= STEP_DONE
+        && error >= -1 && error < SESSION_ERROR_COUNT
+        && valid_positions(session->positions_, n) && valid_positions(session->question_.dimensions, d)
+        && valid_positions(session->final_dimension_list_, d)
+        && (phase != PHASE_3 || !session->final_dimension_list_.empty())
+        && valid_positions(state.C_idx, n) && valid_positions(state.S, state.C_idx.size());
+    if (valid && has_output) {
+        // resolve the output ids with one pass over the skyline
+        std::unordered_map<int, point_t*> points;
+        for (int i = 0; i < n; ++i) points[skyline->points[i]->id] = skyline->points[i];
+        session->output_.S = alloc_point_set(output_ids.size());
+        for (int i = 0; i < output_ids.size(); ++i) {
+            auto found = points.find(output_ids[i]);
+            valid = valid && found != points.end();
+            session->output_.S->points[i] = found == points.end() ? nullptr : found->second;
+        }
+    }
+    if (!valid) {
+        delete session;
+        return nullptr;
+    }
+    session->output_.error = error == -1 ? nullptr : SESSION_ERRORS[error];
+    session->phase_ = session_phase(phase);
+    session->kind_ = question_kind(kind);
+    session->step_ = phase_2_step(step);
+    session->question_.points = skyline_points(skyline, session->positions_);
+    return session;
+}
+
+// the state of the interactive algorithm indexes the skyline of the projection, which is only known once it is built
+bool highdim_session::valid_phase_3_state(){
+    if (phase_ != PHASE_3) return true;
+    ensure_phase_3_projection();
+    int m = skyline_D_prime_->numberOfPoints;
+    return valid_positions(state_.C_idx, m) && valid_positions(state_.frame, m)
+        && state_.current_best_idx >= -1 && state_.current_best_idx < m && state_.last_best >= -1 && state_.last_best < m;
+}
+
+highdim_session* highdim_session::restore(point_set_t* skyline, const std::string& blob, highdim_projection_cache* projections){
+    highdim_session* session = read_snapshot(skyline, blob, projections);
+    if (session != nullptr && !session->valid_phase_3_state()) {
+        delete session;
+        return nullptr;
+    }
+    return session;
+}
+
+highdim_session* highdim_session::clone() const{
+    // the snapshot is the session's own, and its projection is shared below
+    highdim_session* copy = read_snapshot(skyline_, snapshot(), projections_);
+    copy->projection_ = projection_;
+    if (projection_) {
+        copy->D_prime_ = D_prime_;
+        copy->skyline_D_prime_ = skyline_D_prime_;
+    }
+    return copy;
+}
+
+highdim_output* interactive_highdim(point_set_t* skyline, int size, int d_bar, int d_hat, int d_hat_2, point_t* u, int K, int s, double epsilon, int maxRound, double& Qcount, double& Csize, int cmp_option, int stop_option, int prune_option, int dom_option, int& num_questions){
+    highdim_parameters parameters = {size, d_bar, d_hat, d_hat_2, K, s, epsilon, cmp_option, stop_option, prune_option, dom_option, num_questions};
+    // continue the random sequences of the thread, which the experiments seed per trial
+    highdim_random random = {experiment_random_generator(), thread_rand_generator()};
+    highdim_session session(skyline, parameters, random);
+    while (const highdim_question* question = session.next_question()) {
+        session.submit_answer(simulated_answer(*question, u));
+    }
+    experiment_random_generator() = session.random().points;
+    thread_rand_generator() = session.random().options;
+
+    for (int i = 0; i < METRIC_TIMER_COUNT; ++i) {
+        metric_add_time(metric_timer(i), session.seconds(metric_timer(i)));
+    }
+    Qcount = session.phase_3_questions();
+    Csize = session.candidate_size();
+    num_questions = session.remaining_questions();
+
+    const highdim_output& result = session.result();
+    highdim_output* output = new highdim_output(result);
+    output->S = alloc_point_set(result.S->numberOfPoints);
+    for (int i = 0; i < result.S->numberOfPoints; ++i) output->S->points[i] = result.S->points[i];
     return output;
 }
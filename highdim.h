@@ -10,8 +10,12 @@
 #include "time.h"
 #include <cmath>
 #include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <set>
+#include <string>
 #include <vector>
 #include <algorithm>
 #include "other/data_struct.h"
@@ -19,6 +23,7 @@
 #include "other/maxUtility.h"
 #include "attribute_subset.h"
 #include "other/medianhull.h"
+#include "other/metrics.h"
 #include <ctime>
 using namespace std;
 
@@ -28,7 +33,188 @@ struct highdim_output{
     std::set<int> final_dimensions;
     double time_12;
     double time_3;
+    const char* error;  // why the session ended without an output set (S is then empty), nullptr if it has one
 };
 
-// the complete interactive high-dimensional regret algorithm with attribute subset method
-highdim_output* interactive_highdim(point_set_t* skyline, int size, int d_bar, int d_hat, int d_hat_2, point_t* u, int K, int s, double epsilon, int maxRound, double& Qcount, double& Csize, int cmp_option, int stop_option, int prune_option, int dom_option, int& num_questions);
+// the parameters of interactive_highdim
+struct highdim_parameters{
+    int size;           // number of points shown in a question of phases 1 and 2
+    int d_bar;          // number of dimensions to find in phase 2
+    int d_hat;          // number of dimensions in a block of phase 1
+    int d_hat_2;        // number of dimensions in the cover of the attribute subset method
+    int K;              // return size when no question is left for phase 3
+    int s;              // question size of the interactive algorithm of phase 3
+    double epsilon;
+    int cmp_option;
+    int stop_option;
+    int prune_option;
+    int dom_option;
+    int num_questions;  // the question budget
+};
+
+// the random sources of a session: points draws the points of the projected questions and the subsets of the
+// attribute subset method, options draws the points of a RANDOM phase 3 question
+struct highdim_random{
+    std::mt19937 points;
+    std::mt19937 options;
+};
+
+// the answer to a question that shows points when none of them is interesting
+const int HIGHDIM_NO_CHOICE = -1;
+
+// a question of an interactive session
+// a dimension question asks whether the user cares about dimensions[0], and is answered with 1 (yes) or 0 (no)
+// otherwise the user picks one of the points, shown projected onto dimensions, and answers with its position;
+// if allow_none is set the user may answer HIGHDIM_NO_CHOICE instead
+struct highdim_question{
+    bool dimension_question;
+    std::vector<int> dimensions;
+    std::vector<point_t*> points;   // points of the skyline
+    bool allow_none;
+};
+
+// the answer of a simulated user with the utility vector u
+int simulated_answer(const highdim_question& question, point_t* u);
+
+// the projection of a skyline onto the candidate dimensions of phase 3, and the skyline of that projection
+struct highdim_projection{
+    point_set_t* points;
+    point_set_t* skyline;   // shares the points of points
+    frame_cache frames;     // the SIMPLEX frames of skyline, shared by the sessions on the projection
+    highdim_projection(point_set_t* source, const std::vector<int>& dimensions);
+    ~highdim_projection();
+    highdim_projection(const highdim_projection&) = delete;
+    highdim_projection& operator=(const highdim_projection&) = delete;
+};
+
+// the most recently used phase 3 projections of one skyline, shared read-only by the sessions on it;
+// get may be called from several threads
+class highdim_projection_cache{
+public:
+    // the skyline must outlive the cache
+    highdim_projection_cache(point_set_t* skyline, int capacity);
+    std::shared_ptr<highdim_projection> get(const std::vector<int>& dimensions);
+
+private:
+    point_set_t* skyline_;
+    size_t capacity_;
+    std::mutex mutex_;
+    std::list<std::pair<std::vector<int>, std::shared_ptr<highdim_projection>>> entries_;
+};
+
+// interactive_highdim as an explicit state machine, with the user outside of the algorithm
+// the algorithm only computes inside next_question and submit_answer, so a session that waits for its user holds no thread
+class highdim_session{
+public:
+    // the skyline (and the projection cache of the skyline, if any) must outlive the session
+    highdim_session(point_set_t* skyline, const highdim_parameters& parameters, const highdim_random& random,
+        highdim_projection_cache* projections = nullptr);
+    ~highdim_session();
+    highdim_session(const highdim_session&) = delete;
+    highdim_session& operator=(const highdim_session&) = delete;
+
+    // the pending question, or nullptr once the session is finished
+    const highdim_question* next_question();
+    // answer the pending question and compute the next one; false if no question is pending or the answer is invalid
+    bool submit_answer(int answer);
+    // the pending question followed by the phase 1 questions after it, which do not depend on its answer; at most
+    // limit questions, and none once the session is finished. They are the questions next_question returns one by
+    // one, whatever the answers, so answering them together uses the same question budget
+    const std::vector<highdim_question>& next_questions(int limit);
+    // answer the first answers.size() questions of the last next_questions in order; false, with no answer applied,
+    // if there are no answers, more answers than questions, or an invalid answer
+    bool submit_answers(const std::vector<int>& answers);
+
+    bool finished() const { return phase_ == PHASE_FINISHED; }
+    // the output set (points of the skyline) and the candidate dimensions, once finished; answers that leave no
+    // candidate dimension end the session with result().error set
+    const highdim_output& result() const { return output_; }
+    int remaining_questions() const { return remaining_; }
+    // the questions asked and the final candidate set size of the interactive algorithm of phase 3 (Qcount and Csize)
+    int phase_3_questions() const { return state_.rounds; }
+    int candidate_size() const { return candidate_size_; }
+    const highdim_random& random() const { return random_; }
+    // the compute time of the session in a phase, as reported by the metrics
+    double seconds(metric_timer timer) const { return seconds_[timer]; }
+
+    // the complete state of the session as a binary blob, including the pending question;
+    // numbers are stored in memory order, so a blob is read back by a build of the same code on the same platform
+    std::string snapshot() const;
+    // a session continuing from a snapshot taken on the same skyline, without replaying its questions;
+    // a session in phase 3 rebuilds its projection (or takes it from the cache) to check the indexes into it;
+    // nullptr if the blob is invalid
+    static highdim_session* restore(point_set_t* skyline, const std::string& blob, highdim_projection_cache* projections = nullptr);
+    // an independent copy of the session that shares its phase 3 projection, e.g. to answer the pending question
+    // speculatively while the user thinks
+    highdim_session* clone() const;
+
+private:
+    enum session_phase { PHASE_1, PHASE_2, PHASE_3, PHASE_FINISHED };
+    // where phase 2 continues after an answer
+    enum phase_2_step { STEP_OUTER, STEP_SMALL, STEP_SEARCH, STEP_DONE };
+    // what the pending question asks
+    enum question_kind { BLOCK_QUESTION, SMALL_QUESTION, GROUP_QUESTION, SEARCH_DIMENSION_QUESTION, SEARCH_GROUP_QUESTION, PHASE_3_QUESTION };
+
+    static highdim_session* read_snapshot(point_set_t* skyline, const std::string& blob, highdim_projection_cache* projections);
+    bool valid_phase_3_state();
+    void advance();
+    bool phase_1_question();
+    bool phase_2_question();
+    void ensure_phase_3_projection();
+    void start_phase_3();
+    bool phase_3_question();
+    void finish(point_set_t* S_output);
+    void fail(const char* reason);
+    void ask_points(const std::vector<int>& dimensions, question_kind kind);
+    void ask_dimension(int dimension, question_kind kind);
+    void record(int answer);
+    void apply_answer(int answer);
+    void charge(metric_timer timer);
+    metric_timer phase_timer() const;
+
+    point_set_t* skyline_;
+    highdim_parameters parameters_;
+    highdim_random random_;
+    session_phase phase_;
+    int remaining_;
+    question_mapping qm_;
+
+    highdim_question question_;
+    std::vector<int> positions_;    // the positions of question_.points in the skyline
+    bool has_question_;
+    question_kind kind_;
+    std::vector<highdim_question> batch_;   // the last next_questions, until an answer is submitted
+
+    // phase 1
+    int block_;
+    // phase 2
+    dimension_set selected_dimensions_;
+    dimension_set final_dimensions_;
+    int d_left_;
+    int d_target_;
+    phase_2_step step_;
+    int small_index_;
+    int group_size_;
+    int left_;
+    int right_;
+    // phase 3
+    std::set<int> set_final_dimensions_;
+    std::vector<int> final_dimension_list_;
+    highdim_projection_cache* projections_;
+    std::shared_ptr<highdim_projection> projection_;
+    point_set_t* D_prime_;          // the points and the skyline of projection_
+    point_set_t* skyline_D_prime_;
+    max_utility_state state_;
+    int candidate_size_;
+
+    highdim_output output_;
+    double seconds_[METRIC_TIMER_COUNT];
+    std::chrono::steady_clock::time_point mark_;
+};
+
+// show size random points of the skyline projected onto dimensions, answer with the simulated user u,
+// record the question in qm and return the id of the chosen point (-1 if none has positive utility)
+int ask_projected_question(point_set_t* skyline, point_t* u, const std::vector<int>& dimensions, int size, question_mapping& qm);
+
+// the complete interactive high-dimensional regret algorithm with attribute subset method, answered by the simulated user u
+highdim_output* interactive_highdim(point_set_t* skyline, int size, int d_bar, int d_hat, int d_hat_2, point_t* u, int K, int s, double epsilon, int maxRound, double& Qcount, double& Csize, int cmp_option, int stop_option, int prune_option, int dom_option, int& num_questions);
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "json_lines.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+void skip_spaces(const std::string& line, size_t& i){
+    while (i < line.size() && isspace(static_cast<unsigned char>(line[i]))) ++i;
+}
+
+bool parse_string(const std::string& line, size_t& i, std::string& value){
+    if (i >= line.size() || line[i] != '"') return false;
+    ++i;
+    value.clear();
+    while (i < line.size() && line[i] != '"'){
+        char c = line[i++];
+        if (c != '\\'){
+            value += c;
+            continue;
+        }
+        if (i >= line.size()) return false;
+        char escaped = line[i++];
+        switch (escaped){
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'u':
+                // only the ASCII range is needed by the protocols
+                if (i + 4 > line.size()) return false;
+                value += static_cast<char>(strtol(line.substr(i, 4).c_str(), nullptr, 16));
+                i += 4;
+                break;
+            default: value += escaped; break;
+        }
+    }
+    if (i >= line.size()) return false;
+    ++i;
+    return true;
+}
+
+// a nested object or array, returned verbatim
+bool parse_nested(const std::string& line, size_t& i, std::string& value){
+    size_t start = i;
+    int depth = 0;
+    bool in_string = false;
+    for (; i < line.size(); ++i){
+        char c = line[i];
+        if (in_string){
+            if (c == '\\') ++i;
+            else if (c == '"') in_string = false;
+            continue;
+        }
+        if (c == '"') in_string = true;
+        else if (c == '{' || c == '[') ++depth;
+        else if (c == '}' || c == ']'){
+            if (--depth == 0){
+                ++i;
+                value = line.substr(start, i - start);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool parse_json_object(const std::string& line, json_object& object){
+    object.clear();
+    size_t i = 0;
+    skip_spaces(line, i);
+    if (i >= line.size() || line[i] != '{') return false;
+    ++i;
+    skip_spaces(line, i);
+    if (i < line.size() && line[i] == '}') return true;
+    while (i < line.size()){
+        std::string key, value;
+        skip_spaces(line, i);
+        if (!parse_string(line, i, key)) return false;
+        skip_spaces(line, i);
+        if (i >= line.size() || line[i] != ':') return false;
+        ++i;
+        skip_spaces(line, i);
+        if (i >= line.size()) return false;
+        if (line[i] == '"'){
+            if (!parse_string(line, i, value)) return false;
+        }
+        else if (line[i] == '{' || line[i] == '['){
+            if (!parse_nested(line, i, value)) return false;
+        }
+        else {
+            size_t start = i;
+            while (i < line.size() && line[i] != ',' && line[i] != '}' && !isspace(static_cast<unsigned char>(line[i]))) ++i;
+            value = line.substr(start, i - start);
+        }
+        object[key] = value;
+        skip_spaces(line, i);
+        if (i < line.size() && line[i] == ','){
+            ++i;
+            continue;
+        }
+        return i < line.size() && line[i] == '}';
+    }
+    return false;
+}
+
+std::string json_string(const json_object& object, const std::string& key, const std::string& fallback){
+    auto it = object.find(key);
+    return it == object.end() ? fallback : it->second;
+}
+
+long long json_int(const json_object& object, const std::string& key, long long fallback){
+    auto it = object.find(key);
+    if (it == object.end()) return fallback;
+    char* end = nullptr;
+    long long value = strtoll(it->second.c_str(), &end, 10);
+    return end == it->second.c_str() ? fallback : value;
+}
+
+double json_double(const json_object& object, const std::string& key, double fallback){
+    auto it = object.find(key);
+    if (it == object.end()) return fallback;
+    char* end = nullptr;
+    double value = strtod(it->second.c_str(), &end);
+    return end == it->second.c_str() ? fallback : value;
+}
+
+bool json_bool(const json_object& object, const std::string& key, bool fallback){
+    auto it = object.find(key);
+    if (it == object.end()) return fallback;
+    if (it->second == "true" || it->second == "1") return true;
+    if (it->second == "false" || it->second == "0") return false;
+    return fallback;
+}
+
+bool json_int_list(const json_object& object, const std::string& key, std::vector<long long>& values){
+    values.clear();
+    auto it = object.find(key);
+    if (it == object.end()) return false;
+    const std::string& text = it->second;
+    size_t i = 0;
+    skip_spaces(text, i);
+    if (i >= text.size() || text[i] != '[') return false;
+    ++i;
+    skip_spaces(text, i);
+    if (i < text.size() && text[i] == ']') return true;
+    while (i < text.size()){
+        skip_spaces(text, i);
+        char* end = nullptr;
+        long long value = strtoll(text.c_str() + i, &end, 10);
+        if (end == text.c_str() + i) return false;
+        values.push_back(value);
+        i = end - text.c_str();
+        skip_spaces(text, i);
+        if (i < text.size() && text[i] == ','){
+            ++i;
+            continue;
+        }
+        return i < text.size() && text[i] == ']';
+    }
+    return false;
+}
+
+std::string json_escape(const std::string& value){
+    std::string escaped;
+    for (char c : value){
+        switch (c){
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\r': escaped += "\\r"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20){
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                }
+                else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
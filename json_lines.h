@@ -0,0 +1,26 @@
+#ifndef JSON_LINES_H
+#define JSON_LINES_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// a flat JSON object as used by the line protocols: every key maps to its scalar value as text
+// (strings are unescaped, numbers and literals are kept verbatim)
+typedef std::map<std::string, std::string> json_object;
+
+// parse one line holding a flat JSON object; nested objects and arrays are kept as raw text
+bool parse_json_object(const std::string& line, json_object& object);
+
+// typed accessors returning fallback when the key is missing or malformed
+std::string json_string(const json_object& object, const std::string& key, const std::string& fallback = "");
+long long json_int(const json_object& object, const std::string& key, long long fallback);
+double json_double(const json_object& object, const std::string& key, double fallback);
+bool json_bool(const json_object& object, const std::string& key, bool fallback);
+// an array of integers; false when the key is missing or not such an array
+bool json_int_list(const json_object& object, const std::string& key, std::vector<long long>& values);
+
+// escape a string for use inside a JSON string literal
+std::string json_escape(const std::string& value);
+
+#endif
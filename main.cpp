@@ -7,6 +7,9 @@
 #include "other/lp.h"
 #include "highdim.h"
 #include "experiment_random.h"
+#include "experiment.h"
+#include "experiment_worker.h"
+#include "session_server.h"
 
 
 #include <iostream>
@@ -23,6 +26,7 @@ using namespace std;
 #include <fstream>
 #include <iomanip>
 #include <string>
+#include <thread>
 
 namespace {
 
@@ -54,98 +58,70 @@ point_t* generate_sparse_utility(int d, int d_prime){
 	return u;
 }
 
-point_t* read_experiment_utility(const std::string& path, int dimension){
-	std::ifstream input(path);
-	point_t* utility = alloc_point(dimension);
-	for (int i = 0; i < dimension; ++i) {
-		if (!(input >> utility->coord[i])) {
-			release_point(utility);
-			return nullptr;
-		}
-	}
-	return utility;
-}
-
-void print_experiment_result(const char* method, double regret_ratio, double time_seconds,
-		int output_size, int questions){
-	std::cout << "EXPERIMENT_RESULT {\"method\":\"" << method
-		<< "\",\"status\":\"ok\",\"regret_ratio\":" << std::setprecision(17) << regret_ratio
-		<< ",\"time_seconds\":" << time_seconds
-		<< ",\"output_size\":" << output_size
-		<< ",\"questions\":" << questions << "}" << std::endl;
+void print_usage(){
+	printf("usage: ./run <dataset> <d_int> <m> <w> <K> <q>\n");
+	printf("       ./run --experiment <dataset> <d_int> <m> <w> <K> <q> <utility_file> <seed> <skip_sphere>\n");
+	printf("       ./run --batch <dataset> <manifest> [threads] [--hull]\n");
+	printf("       ./run --worker [--socket <path>] [--cache <datasets>] [--hull]\n");
+	printf("       ./run --serve [--socket <path>] [--threads <n>] [--speculate <answers>] [--dataset <path>]... [--cache <datasets>] [--hull]\n");
 }
 
-void print_unavailable_experiment_result(const char* method, const char* reason){
-	std::cout << "EXPERIMENT_RESULT {\"method\":\"" << method
-		<< "\",\"status\":\"unavailable\",\"reason\":\"" << reason << "\"}" << std::endl;
-}
+} // namespace
 
-point_set_t* construct_sphere_dataset(point_set_t* skyline, const std::set<int>& final_dimensions){
-	point_set_t* D_test = alloc_point_set(skyline->numberOfPoints);
-	for (int i = 0; i < skyline->numberOfPoints; i++) {
-		D_test->points[i] = alloc_point(final_dimensions.size());
-		// Set the ID to be the array index so we can map back correctly
-		D_test->points[i]->id = i;
-		int j = 0;
-		for (auto dim : final_dimensions) {
-			D_test->points[i]->coord[j++] = skyline->points[i]->coord[dim];
-		}
+//interactive version
+int main(int argc, char *argv[]){
+	// --hull, which reduces the skyline to its hull vertices, may end the command line of every server mode
+	const bool hull = argc >= 3 && std::string(argv[argc - 1]) == "--hull";
+	if (hull) argc--;
+	if (argc >= 4 && argc <= 5 && std::string(argv[1]) == "--batch") {
+		int num_threads = argc == 5 ? atoi(argv[4]) : 1;
+		return run_experiment_batch(argv[2], argv[3], num_threads, hull);
 	}
-	return D_test;
-}
-
-point_set_t* copy_sphere_result_to_original(point_set_t* skyline, point_set_t* skyline_D_test, point_set_t* S_test){
-	point_set_t* S_test_original = alloc_point_set(S_test->numberOfPoints);
-	int valid_index = 0;
-	for (int i = 0; i < S_test->numberOfPoints; i++){
-		int target_id = S_test->points[i]->id;
-
-		// Find the point in skyline_D_test with this ID
-		int skyline_index = -1;
-		for (int j = 0; j < skyline_D_test->numberOfPoints; j++) {
-			if (skyline_D_test->points[j]->id == target_id) {
-				skyline_index = j;
-				break;
+	if (argc >= 2 && std::string(argv[1]) == "--worker") {
+		const char* socket_path = nullptr;
+		int cache_size = 4;
+		for (int i = 2; i < argc; i += 2) {
+			std::string option = argv[i];
+			if (i + 1 >= argc || (option != "--socket" && option != "--cache")) {
+				print_usage();
+				return 2;
 			}
+			if (option == "--socket") socket_path = argv[i + 1];
+			else cache_size = atoi(argv[i + 1]);
 		}
-
-		if (skyline_index == -1) {
-			continue;
-		}
-
-		// Get the corresponding point from D_test (which has the array index)
-		point_t* D_test_point = skyline_D_test->points[skyline_index];
-		int original_skyline_index = D_test_point->id;
-
-		if (original_skyline_index < 0 || original_skyline_index >= skyline->numberOfPoints) {
-			continue;
-		}
-
-		// Create a new point with original dimensions
-		point_t* original_point = skyline->points[original_skyline_index];
-		if (original_point == NULL) {
-			continue;
-		}
-
-		point_t* new_point = alloc_point(original_point->dim);
-		new_point->id = original_point->id;
-		for (int j = 0; j < original_point->dim; j++) {
-			new_point->coord[j] = original_point->coord[j];
+		return run_experiment_worker(socket_path, cache_size, hull);
+	}
+	if (argc >= 2 && std::string(argv[1]) == "--serve") {
+		const char* socket_path = nullptr;
+		int num_threads = std::thread::hardware_concurrency();
+		int speculate = 4;
+		int cache_size = 4;
+		std::vector<std::string> datasets;
+		for (int i = 2; i < argc; i += 2) {
+			std::string option = argv[i];
+			if (i + 1 >= argc || (option != "--socket" && option != "--threads" && option != "--speculate" && option != "--dataset" && option != "--cache")) {
+				print_usage();
+				return 2;
+			}
+			if (option == "--socket") socket_path = argv[i + 1];
+			else if (option == "--threads") num_threads = atoi(argv[i + 1]);
+			else if (option == "--speculate") speculate = atoi(argv[i + 1]);
+			else if (option == "--cache") cache_size = atoi(argv[i + 1]);
+			else datasets.push_back(argv[i + 1]);
 		}
-		S_test_original->points[valid_index++] = new_point;
+		return run_session_server(socket_path, num_threads, speculate, datasets, cache_size, hull);
+	}
+	if (hull) {
+		print_usage();
+		return 2;
 	}
-	return S_test_original;
-}
-
-} // namespace
-
-//interactive version
-int main(int argc, char *argv[]){
 	const bool experiment_mode = argc == 11 && std::string(argv[1]) == "--experiment";
-	if (!experiment_mode && argc != 7) return 0;
+	if (!experiment_mode && argc != 7) {
+		print_usage();
+		return 0;
+	}
 	char* input = experiment_mode ? argv[2] : argv[1];
 	point_set_t* P = read_points(input);
-	int n = P->numberOfPoints;
 	linear_normalize(P);
 	// reduce_to_unit(P);
 	int d = P->points[0]->dim;
@@ -159,36 +135,22 @@ int main(int argc, char *argv[]){
 	}
 	printf("number of skyline points: %d\n", skyline->numberOfPoints);
 
-	int size = 2; // question size
 	int argument_offset = experiment_mode ? 1 : 0;
-	int d_prime = atoi(argv[2 + argument_offset]); // number of dimensions in the utility vector
-	int d_hat = atoi(argv[3 + argument_offset]); // number of dimensions in the cover in phase 1 (d_hat_1)
-	int d_hat_2 = atoi(argv[4 + argument_offset]); // number of dimensions in the cover in phase 3, attribute subset method
-	// int rounds = atoi(argv[5]); // number of random samples in attribute subset method
-	int K = atoi(argv[5 + argument_offset]); // return size of the attribute subset method
-	int d_bar = 5;
-	int num_questions = atoi(argv[6 + argument_offset]); // number of questions allowed
-	int num_quest_init = num_questions; // keep the initial amount of questions allowed
-	// below are default parameters from the interactive paper
-	//-------------------------------------
-	int s = 3; //question size in interactive algorithm (3 as default)
-	double epsilon = 0.0;
-	int maxRound = 1000;
-	double Qcount, Csize;
-	int prune_option = RTREE;
-	int dom_option = HYPER_PLANE;
-	int stop_option = EXACT_BOUND;
-	int cmp_option = RANDOM;
-	//-------------------------------------
-	//set n  to be the number of skyline points
-	n = skyline->numberOfPoints;
+	experiment_parameters parameters;
+	parameters.d_prime = atoi(argv[2 + argument_offset]); // number of dimensions in the utility vector
+	parameters.d_hat = atoi(argv[3 + argument_offset]); // number of dimensions in the cover in phase 1 (d_hat_1)
+	parameters.d_hat_2 = atoi(argv[4 + argument_offset]); // number of dimensions in the cover in phase 3, attribute subset method
+	parameters.K = atoi(argv[5 + argument_offset]); // return size of the attribute subset method
+	parameters.num_questions = atoi(argv[6 + argument_offset]); // number of questions allowed
+	parameters.skip_sphere = false;
+	parameters.cmp_option = RANDOM;
+	parameters.dom_option = HYPER_PLANE;
 
 	point_t* u;
-	bool skip_sphere = false;
 	if (experiment_mode) {
 		seed_experiment_random(static_cast<unsigned int>(std::stoul(argv[9])));
 		u = read_experiment_utility(argv[8], d);
-		skip_sphere = atoi(argv[10]) != 0;
+		parameters.skip_sphere = atoi(argv[10]) != 0;
 		if (u == nullptr) {
 			std::cerr << "Error: invalid utility file " << argv[8] << "\n";
 			release_point_set(skyline, false);
@@ -197,87 +159,30 @@ int main(int argc, char *argv[]){
 		}
 	}
 	else {
-		u = generate_sparse_utility(d, d_prime);
+		u = generate_sparse_utility(d, parameters.d_prime);
 	}
 
-	highdim_output* h = interactive_highdim(skyline, size, d_bar, d_hat, d_hat_2, u, K, s, epsilon, maxRound, Qcount, Csize, cmp_option, stop_option, prune_option, dom_option, num_questions);
-	double time_12 = h->time_12;
-	double time_3 = h->time_3;
-	
-	point_set_t* S = h->S;
-	std::set<int> final_dimensions = h->final_dimensions;
-
-	// evaluation
-	// for comparison, evaluate the performance of Sphere. the return size is either
-	// (# questions asked in interactive algorithm) * s (Phase 3B) or K (Phase 3A)
-	int K_sphere;
-	if (S->numberOfPoints == 1){
-		printf("Phase 3A: \n");
-		K_sphere =  Qcount * s;
-
-	}
-	else{
-		printf("Phase 3B: \n");
-		K_sphere = K;
-	}
+	experiment_outcome outcome = run_experiment_trial(skyline, u, parameters);
+	printf(outcome.phase_3a ? "Phase 3A: \n" : "Phase 3B: \n");
 
 	print_separator();
 	printf("|%7s |%13s |%5s | %5s |\n", "Method", "Regret Ratio", "Time", "Size");
 	print_separator();
-	double mrr = evaluateLP(skyline, S, 0, u);
-	printf("|%7s |%13.3lf |%5.2lf | %5d |\n", "OurAlg", mrr, time_12+time_3, S->numberOfPoints);
-	int questions_used = num_quest_init-num_questions;
-	if (experiment_mode) {
-		print_experiment_result("FHDR", mrr, time_12+time_3, S->numberOfPoints, questions_used);
-	}
-
-	// for comparison, test the mrr returned by the Sphere algorithm
-	// construct the dataset with the final dimensions
-	point_set_t* D_test = construct_sphere_dataset(skyline, final_dimensions);
-	// record the time in seconds
-	if (!skip_sphere && final_dimensions.size() <= K_sphere){
-		auto start_time_sphere = std::chrono::high_resolution_clock::now();
-		point_set_t* skyline_D_test = skyline_point(D_test);
-		point_set_t* S_test = sphereWSImpLP(skyline_D_test, K_sphere);
-		auto end_time_sphere = std::chrono::high_resolution_clock::now();
-		std::chrono::duration<double> duration_sphere = end_time_sphere - start_time_sphere;
-		double time_sphere = duration_sphere.count();
-
-		point_set_t* S_test_original = copy_sphere_result_to_original(skyline, skyline_D_test, S_test);
-		double mrr_test = evaluateLP(skyline, S_test_original, 0, u);
-		
+	printf("|%7s |%13.3lf |%5.2lf | %5d |\n", "OurAlg", outcome.regret_ratio, outcome.time_seconds, outcome.output_size);
+	if (outcome.sphere_available) {
 		print_separator();
-		printf("|%7s |%13.3lf |%5.2lf | %5d |\n", "Sphere", mrr_test, time_12+time_sphere, S_test->numberOfPoints);
-		if (experiment_mode) {
-			print_experiment_result("Sphere-Adapt", mrr_test, time_12+time_sphere,
-				S_test->numberOfPoints, questions_used);
-		}
-	    
-		release_point_set(skyline_D_test, false);
-		release_point_set(S_test, false); // Don't clear since points are references
-		release_point_set(S_test_original, true);
+		printf("|%7s |%13.3lf |%5.2lf | %5d |\n", "Sphere", outcome.sphere_regret_ratio, outcome.sphere_time_seconds, outcome.sphere_output_size);
 	}
-	else if (experiment_mode) {
-		print_unavailable_experiment_result("Sphere-Adapt",
-			skip_sphere ? "skipped_by_experiment_policy" : "candidate_dimension_count_exceeds_output_size");
+	if (experiment_mode) {
+		std::cout << format_experiment_records(outcome, "") << std::flush;
 	}
-	
-	
-
 
-	// Create a new point set with original dimensions
-	// The IDs in S_test->points[i] are the original IDs from the input points
-	// We need to find the points in skyline_D_test that have those IDs
-	
 	print_separator();
-	printf("number of questions: %d\n", questions_used); // 555
+	printf("number of questions: %d\n", outcome.questions); // 555
 
 	release_point_set(skyline, false);
 	release_point(u);
-	release_point_set(h->S, false);
 	release_point_set(P, true);
-	release_point_set(D_test, true);
-	delete h;
 
 	return 0;
 }
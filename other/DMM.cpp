@@ -51,77 +51,118 @@ point_set_t* discretize(int gamma, int dim)
 	return F;
 }
 
-point_set_t* MRST_oracle(double **M, int n, int m, double eps, point_set_t* point_set)
+// the multiply-adds below which the regret matrix is divided on one thread
+const double PARALLEL_WORK = 1 << 22;
+
+// run body(first, last) on consecutive ranges of the rows [0, n), one range per thread
+template <typename Body>
+void for_row_ranges(int n, int threads, Body body)
 {
-	int** M_tmp = new int*[n];
-	for (int i = 0; i < n; i++)
-	{
-		M_tmp[i] = new int[m];
-	}
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back(body, (long)n * t / threads, (long)n * (t + 1) / threads);
+	body(0, n / threads);
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
 
-	int* count = new int[n];
-	//printf("----eps: %lf----\n", eps);
-	for (int i = 0; i < n; i++)
-	{
-		count[i] = 0;
-		for (int j = 0; j < m; j++)
+// the regret ratio of every point of point_set on every direction of F, by rows in one piece:
+// M[i * m + j] is the regret ratio of point i on direction j
+// every dot product is computed once: batch_argmax fills the rows with them together with the column maxima, and
+// then they are divided
+std::vector<double> regret_matrix(point_set_t* point_set, point_set_t* F)
+{
+	int n = point_set->numberOfPoints;
+	int m = F->numberOfPoints;
+	int dim = point_set->points[0]->dim;
+	std::vector<double> M((size_t)n * m);
+
+	std::vector<double> directions((size_t)m * dim);
+	for (int j = 0; j < m; j++)
+		std::copy(F->points[j]->coord, F->points[j]->coord + dim, &directions[(size_t)j * dim]);
+	std::vector<double> max(m);
+	std::vector<int> argmax(m);
+	batch_argmax(point_set, &directions[0], m, &max[0], &argmax[0], &M[0]);
+
+	int threads = 1;
+	if ((double)n * m * dim >= PARALLEL_WORK)
+		threads = std::max(1, std::min(kernel_threads(), n));
+	for_row_ranges(n, threads, [&](int first, int last) {
+		for (int i = first; i < last; i++)
 		{
-			M_tmp[i][j] = (M[i][j] < eps || isZero(M[i][j]-eps))? 1:0;
-			count[i]+= M_tmp[i][j];
+			double* row = &M[(size_t)i * m];
+			for (int j = 0; j < m; j++)
+				row[j] = 1 - row[j] / max[j];
 		}
-	}
+	});
+	return M;
+}
 
-	
-	int totalCount = m;
-	vector<point_t*> selected;
-	while (totalCount > 0)
+// the buffers of MRST_oracle, reused by the calls of one threshold search
+struct mrst_buffers
+{
+	std::vector<uint64_t> rows;				// the directions each point covers, words per point
+	std::vector<uint64_t> covered;
+	std::vector<std::pair<int, int> > heap;	// (bound on the directions a point still covers, -index of the point)
+	std::vector<int> selected;
+};
+
+// greedy set cover of the m directions by the points with regret ratio at most eps on them, into buffers.selected
+// the point covering the most uncovered directions is taken first (the smallest index on ties); the counts only
+// decrease, so a point whose recounted directions still reach its bound in the heap is the one to take
+// stops once more than limit points are selected
+void MRST_oracle(const std::vector<double>& M, int n, int m, double eps, int limit, mrst_buffers& buffers)
+{
+	int words = (m + 63) / 64;
+	buffers.rows.assign((size_t)n * words, 0);
+	buffers.covered.assign(words, 0);
+	buffers.heap.clear();
+	buffers.selected.clear();
+
+	for (int i = 0; i < n; i++)
 	{
-		int maxCount = 0;
-		int maxI;
-		for (int i = 0; i < n; i++)
+		const double* values = &M[(size_t)i * m];
+		uint64_t* row = &buffers.rows[(size_t)i * words];
+		int count = 0;
+		for (int j = 0; j < m; j++)
 		{
-			if (maxCount < count[i])
+			if (values[j] < eps || isZero(values[j] - eps))
 			{
-				maxI = i;
-				maxCount = count[i];
+				row[j / 64] |= uint64_t(1) << (j % 64);
+				count++;
 			}
 		}
+		if (count > 0)
+			buffers.heap.push_back(std::make_pair(count, -i));
+	}
+	std::make_heap(buffers.heap.begin(), buffers.heap.end());
 
-		totalCount -= maxCount;
-		selected.push_back(point_set->points[maxI]);
-
-		for (int i = 0; i < m; i++)
+	int totalCount = m;
+	while (totalCount > 0 && (int)buffers.selected.size() <= limit && !buffers.heap.empty())
+	{
+		std::pop_heap(buffers.heap.begin(), buffers.heap.end());
+		std::pair<int, int> top = buffers.heap.back();
+		buffers.heap.pop_back();
+
+		const uint64_t* row = &buffers.rows[(size_t)-top.second * words];
+		int count = 0;
+		for (int w = 0; w < words; w++)
+			count += __builtin_popcountll(row[w] & ~buffers.covered[w]);
+		if (count < top.first)
 		{
-			if (M_tmp[maxI][i] == 1)
+			if (count > 0)
 			{
-				for (int j = 0; j < n; j++)
-				{
-					if (M_tmp[j][i] == 1)
-					{
-						M_tmp[j][i] = 0;
-						count[j]--;
-					}
-				}
+				buffers.heap.push_back(std::make_pair(count, top.second));
+				std::push_heap(buffers.heap.begin(), buffers.heap.end());
 			}
+			continue;
 		}
 
+		totalCount -= count;
+		buffers.selected.push_back(-top.second);
+		for (int w = 0; w < words; w++)
+			buffers.covered[w] |= row[w];
 	}
-
-	point_set_t* S = alloc_point_set(selected.size());
-
-	for (int i = 0; i < selected.size(); i++)
-	{
-		S->points[i] = selected[i];
-	}
-
-	delete[] count;
-	for (int i = 0; i < n; i++)
-	{
-		delete[] M_tmp[i];
-	}
-	delete[] M_tmp;
-
-	return S;
 }
 
 point_set_t* DMM(point_set_t* point_set, int k)
@@ -136,54 +177,26 @@ point_set_t* DMM(point_set_t* point_set, int k)
 	int n = point_set->numberOfPoints;
 	int m = F->numberOfPoints;
 
-	double** M = new double*[n];
-	for (int i = 0; i < n; i++)
-	{
-		M[i] = new double[m];
-	}
-
-	for (int j = 0; j < m; j++)
-	{
-		double max = 0;
-		for (int i = 0; i < point_set->numberOfPoints; i++)
-		{
-			double temp = dot_prod(F->points[j], point_set->points[i]);
-			if (temp > max)
-				max = temp;
-		}
-
-		for (int i = 0; i < n; i++)
-		{
-			
-			M[i][j] = 1 - dot_prod(F->points[j], point_set->points[i]) / max;
-		}
-	}
+	std::vector<double> M = regret_matrix(point_set, F);
+	release_point_set(F, true);
 
-	std::set<double> sortedV_set;
-	std::set<double>::iterator it;
-	for (int i = 0; i < n; i++)
-	{
-		for (int j = 0; j < m; j++)
-		{
-			double value = M[i][j];
-			sortedV_set.insert(M[i][j] );
-		}
-	}
-	vector<double> sortedV;
-	for (it = sortedV_set.begin(); it != sortedV_set.end(); ++it)
-	{
-		sortedV.push_back((*it) );
-	}
+	// the distinct regret ratios in increasing order
+	std::vector<double> sortedV(M);
+	std::sort(sortedV.begin(), sortedV.end());
+	sortedV.erase(std::unique(sortedV.begin(), sortedV.end()), sortedV.end());
+	sortedV.shrink_to_fit();
 
+	// the search only needs to know whether more than k points are selected
+	mrst_buffers buffers;
 	int low = 0, high = sortedV.size();
 	while (low < high)
 	{
 		
 		int mid = (low + high) / 2;
 
-		point_set_t* tmp = MRST_oracle(M, n, m, sortedV[mid], point_set);
+		MRST_oracle(M, n, m, sortedV[mid], k, buffers);
 
-		if (tmp->numberOfPoints <= k)
+		if (buffers.selected.size() <= k)
 		{
 			high = mid;
 		}
@@ -191,16 +204,15 @@ point_set_t* DMM(point_set_t* point_set, int k)
 		{
 			low = mid + 1;
 		}
-		release_point_set(tmp, false);
 
 	}
-	point_set_t* result = MRST_oracle(M, n, m, sortedV[low], point_set);
+	MRST_oracle(M, n, m, sortedV[low], n, buffers);
 
-	for (int i = 0; i < n; i++)
+	point_set_t* result = alloc_point_set(buffers.selected.size());
+	for (int i = 0; i < buffers.selected.size(); i++)
 	{
-		delete[] M[i];
+		result->points[i] = point_set->points[buffers.selected[i]];
 	}
-	delete[] M;
 
 	return result;
 }
@@ -215,28 +227,8 @@ point_set_t* DMM_Greedy(point_set_t* point_set, int k)
 	int n = point_set->numberOfPoints;
 	int m = F->numberOfPoints;
 
-	double** M = new double*[n];
-	for (int i = 0; i < n; i++)
-	{
-		M[i] = new double[m];
-	}
-
-	for (int j = 0; j < m; j++)
-	{
-		double max = 0;
-		for (int i = 0; i < point_set->numberOfPoints; i++)
-		{
-			double temp = dot_prod(F->points[j], point_set->points[i]);
-			if (temp > max)
-				max = temp;
-		}
-
-		for (int i = 0; i < n; i++)
-		{
-			
-			M[i][j] = 1 - dot_prod(F->points[j], point_set->points[i]) / max;
-		}
-	}
+	std::vector<double> M = regret_matrix(point_set, F);
+	release_point_set(F, true);
 
 
 
@@ -279,30 +271,31 @@ point_set_t* DMM_Greedy(point_set_t* point_set, int k)
 
 	int count = dim;
 
+	// the smallest regret ratio of the selected points on each direction, walking the matrix by rows
+	std::vector<double> min(m);
 	while(count < k)
 	{
-		double max = -1;
-		int maxJ = -1;
-		for(int j = 0; j < m; j++)
+		std::fill(min.begin(), min.end(), INF);
+		for(int i = 0; i < n; i++)
 		{
-			int minI = -1;
-			double min = INF;
-			for(int i = 0; i < n; i++)
+			if(activeI[i])
+				continue;
+
+			const double* values = &M[(size_t)i * m];
+			for(int j = 0; j < m; j++)
 			{
-				if(activeI[i])
-					continue;
-
-				if(M[i][j] < min)
-				{
-					min = M[i][j];
-					minI = i;
-				}
+				if(values[j] < min[j])
+					min[j] = values[j];
 			}
+		}
 
-			
-			if(max < min)
+		double max = -1;
+		int maxJ = -1;
+		for(int j = 0; j < m; j++)
+		{
+			if(max < min[j])
 			{
-				max = min;
+				max = min[j];
 				maxJ = j;
 			}
 		}
@@ -314,9 +307,9 @@ point_set_t* DMM_Greedy(point_set_t* point_set, int k)
 			if(!activeI[i])
 				continue;
 
-			if(selectMin > M[i][maxJ])
+			if(selectMin > M[(size_t)i * m + maxJ])
 			{
-				selectMin = M[i][maxJ];
+				selectMin = M[(size_t)i * m + maxJ];
 				selectI = i;
 			}
 		}
@@ -325,12 +318,7 @@ point_set_t* DMM_Greedy(point_set_t* point_set, int k)
 		activeI[selectI] = 0;
 	}
 
-	for (int i = 0; i < n; i++)
-	{
-		delete[] M[i];
-	}
-	delete[] M;
 	delete[] activeI;
 
 	return result;
-}
\ No newline at end of file
+}
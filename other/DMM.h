@@ -1,10 +1,16 @@
 #ifndef DMM_H
 #define DMM_H
 
+#include "batch_argmax.h"
 #include "data_utility.h"
+#include "kernel_threads.h"
 #include "operation.h"
 #include <algorithm>
+#include <cstdint>
 #include <set>
+#include <thread>
+#include <utility>
+#include <vector>
 
 point_set_t* DMM(point_set_t* point_set, int k);
 
@@ -1,4 +1,10 @@
 #include "GeoGreedy.h" 
+#include "metrics.h"
+#include "pruning.h"
+
+#include <functional>
+#include <queue>
+#include <unordered_map>
 
 /*<html><pre>  -<a                             href="../libqhull/qh-qhull.htm"
   >-------------------------------</a><a name="TOP">-</a>
@@ -331,10 +337,34 @@ Except for 'F.' and 'PG', upper-case options take an argument.\n\
 typedef struct greedy_info
 {
 	double bestCR;
-	facetT *facet;
+	unsigned facet_id;	// the facet bestCR was computed against; NO_FACET if no facet brings it below 1
 	bool pruned;
 }	greedy_info_t;
 
+const unsigned NO_FACET = (unsigned)-1;
+
+// the critical ratio of a point, capped at 1: the factor by which the point can be scaled before it leaves the
+// current hull, through the facet returned in facet_id
+// the hull only grows, so the ratio of a point never decreases
+double critical_ratio(point_t* pt, unsigned& facet_id)
+{
+	facetT *facet;
+	double minCR = 1;
+	facet_id = NO_FACET;
+	FORALLfacets{
+		if (!isZero(facet->offset))
+		{
+			double newCR = -facet->offset / dot_prod(pt, facet->normal);
+			if (minCR > newCR)
+			{
+				minCR = newCR;
+				facet_id = facet->id;
+			}
+		}
+	}
+	return minCR;
+}
+
 // insert point in GeoGreedy
 bool insert_point(double* pt, int start, int dim)
 {
@@ -367,6 +397,9 @@ bool insert_point(double* pt, int start, int dim)
 // GeoGreedy
 point_set_t* geoGreedy(int K, point_set_t *p)
 {
+	// the hull is built in qhull's global state
+	std::lock_guard<std::mutex> lock(qhull_mutex);
+
 	int size = p->numberOfPoints;
 	int dim = p->points[0]->dim;
 
@@ -375,7 +408,7 @@ point_set_t* geoGreedy(int K, point_set_t *p)
 	{
 		dataIndex[i] = (greedy_info *)malloc(sizeof(greedy_info));
 		dataIndex[i]->pruned = false;
-		dataIndex[i]->facet = NULL;
+		dataIndex[i]->facet_id = NO_FACET;
 	}
 
 	int orthNum = pow(2.0, dim) - 1;
@@ -426,6 +459,8 @@ point_set_t* geoGreedy(int K, point_set_t *p)
 		qh_init_B(points, count, dim, ismalloc);
 		qh_qhull();
 		qh_check_output();
+		metric_add(METRIC_QHULL_CALLS);
+		metric_add(METRIC_QHULL_VERTICES, qh num_vertices);
 
 
 
@@ -435,105 +470,98 @@ point_set_t* geoGreedy(int K, point_set_t *p)
 
 		facetT *facet;
 
-
-		int nextIndex;
-		double global_minCR;
-		do
+		// lazy greedy: the ratios in the queue are lower bounds of the current ones, and a ratio is still current
+		// while the facet it was computed against is unchanged, so only the points popped with a replaced facet are
+		// recomputed; ties go to the smallest index
+		typedef std::pair<double, int> ratio_entry;
+		std::priority_queue<ratio_entry, std::vector<ratio_entry>, std::greater<ratio_entry> > queue;
+		std::unordered_map<unsigned, facetT*> facets;
+		for (int i = 0; i < size && currentK < K; i++)
 		{
-			nextIndex = -1;
-			global_minCR = 1;
+			if (dataIndex[i]->pruned)
+				continue;
+			dataIndex[i]->bestCR = critical_ratio(p->points[i], dataIndex[i]->facet_id);
+			if (isZero(1 - dataIndex[i]->bestCR))
+				dataIndex[i]->pruned = true;
+			else
+				queue.push(ratio_entry(dataIndex[i]->bestCR, i));
+		}
 
+		while (currentK < K && !queue.empty())
+		{
+			facets.clear();
+			FORALLfacets
+				facets[facet->id] = facet;
 
-			for (int i = 0; i < size; i++)
+			int nextIndex = -1;
+			while (!queue.empty())
 			{
-				double minCR = 1;
-				facetT *bestFacet;
-				if (!dataIndex[i]->pruned)
-				{
-					bool update = true;
-
-					FORALLfacets{
-						if (!isZero(facet->offset))
-						{
-							double newCR = -facet->offset / dot_prod(p->points[i],  facet->normal);
-							if (minCR > newCR) {
-								minCR = newCR;
-								bestFacet = facet;
-							}
-							if (global_minCR > newCR)
-							{
-								global_minCR = newCR;
-								nextIndex = i;
-							}
-						}
-					}
-						if (update)
-						{
-							dataIndex[i]->facet = bestFacet;
-							dataIndex[i]->bestCR = minCR;
-						}
-				}
-
-				if (!dataIndex[i]->pruned && isZero(1 - minCR))
+				int i = queue.top().second;
+				queue.pop();
+				greedy_info* info = dataIndex[i];
+				auto found = facets.find(info->facet_id);
+				if (info->facet_id == NO_FACET
+					|| (found != facets.end() && -found->second->offset / dot_prod(p->points[i], found->second->normal) == info->bestCR))
 				{
-					dataIndex[i]->pruned = true;
+					nextIndex = i;
+					break;
 				}
+				info->bestCR = critical_ratio(p->points[i], info->facet_id);
+				if (isZero(1 - info->bestCR))
+					info->pruned = true;
+				else
+					queue.push(ratio_entry(info->bestCR, i));
 			}
-
-			if (isZero(1 - global_minCR))
+			// every point is in the hull
+			if (nextIndex == -1)
 				break;
 
-			if (currentK < K)
-			{
-				coordT *point;
-				facetT *nearfacet;
-				boolT isoutside;
-				realT bestdist;
-				pointT *furthest;
+			coordT *point;
+			boolT isoutside;
+			realT bestdist;
+			pointT *furthest;
 
-				point = (coordT*)qh_malloc(((dim)*sizeof(coordT)));
-				for (int i = 0; i < dim; i++)
-					point[i] = p->points[nextIndex]->coord[i];
-				dataIndex[nextIndex]->pruned = true;
+			point = (coordT*)qh_malloc(((dim)*sizeof(coordT)));
+			for (int i = 0; i < dim; i++)
+				point[i] = p->points[nextIndex]->coord[i];
+			dataIndex[nextIndex]->pruned = true;
 
 
 
 
-				qh_partitionpoint(point, qh facet_list);
+			qh_partitionpoint(point, qh facet_list);
 
-				insert_point(point, 0, dim);
+			insert_point(point, 0, dim);
 
 
-				qh facet_next = qh facet_list;      /* advance facet when processed */
-				while ((furthest = qh_nextfurthest(&facet))) {
-					qh num_outside--;  /* if ONLYmax, furthest may not be outside */
-					if (!qh_addpoint(furthest, facet, qh ONLYmax))
-						break;
-				}
+			qh facet_next = qh facet_list;      /* advance facet when processed */
+			while ((furthest = qh_nextfurthest(&facet))) {
+				qh num_outside--;  /* if ONLYmax, furthest may not be outside */
+				if (!qh_addpoint(furthest, facet, qh ONLYmax))
+					break;
+			}
 
-				if (1)
-				{
-					int numoutside;
-					if (qh MERGEexact || (qh hull_dim > qh_DIMreduceBuild && qh PREmerge))
-						qh_postmerge("First post-merge", qh premerge_centrum, qh premerge_cos, (qh POSTmerge ? False : qh TESTvneighbors));
-					else if (!qh POSTmerge && qh TESTvneighbors)
-						qh_postmerge("For testing vertex neighbors", qh premerge_centrum, qh premerge_cos, True);
-					if (qh POSTmerge)
-						qh_postmerge("For post-merging", qh postmerge_centrum, qh postmerge_cos, qh TESTvneighbors);
-					if (qh visible_list == qh facet_list) { /* i.e., merging done */
-						qh findbestnew = True;
-						qh_partitionvisible(/*visible_list, newfacet_list*/ !qh_ALL, &numoutside);
-						qh findbestnew = False;
-						qh_deletevisible(/*qh visible_list*/);
-						qh_resetlists(False, qh_RESETvisible /*qh visible_list newvertex_list newfacet_list */);
-					}
+			if (1)
+			{
+				int numoutside;
+				if (qh MERGEexact || (qh hull_dim > qh_DIMreduceBuild && qh PREmerge))
+					qh_postmerge("First post-merge", qh premerge_centrum, qh premerge_cos, (qh POSTmerge ? False : qh TESTvneighbors));
+				else if (!qh POSTmerge && qh TESTvneighbors)
+					qh_postmerge("For testing vertex neighbors", qh premerge_centrum, qh premerge_cos, True);
+				if (qh POSTmerge)
+					qh_postmerge("For post-merging", qh postmerge_centrum, qh postmerge_cos, qh TESTvneighbors);
+				if (qh visible_list == qh facet_list) { /* i.e., merging done */
+					qh findbestnew = True;
+					qh_partitionvisible(/*visible_list, newfacet_list*/ !qh_ALL, &numoutside);
+					qh findbestnew = False;
+					qh_deletevisible(/*qh visible_list*/);
+					qh_resetlists(False, qh_RESETvisible /*qh visible_list newvertex_list newfacet_list */);
 				}
-
-				S->points[currentK++] = p->points[nextIndex];
-
 			}
 
-		} while (currentK < K);
+			S->points[currentK++] = p->points[nextIndex];
+
+		}
 
 		for (int i = currentK; i < K; i++)
 			S->points[i] = S->points[0];
@@ -555,6 +583,7 @@ point_set_t* geoGreedy(int K, point_set_t *p)
 		free(dataIndex[i]);
 	}
 	free(dataIndex);
+	delete[] maxIndex;
 
 	//print_point_set(S);
 
@@ -0,0 +1,149 @@
+#include "batch_argmax.h"
+#include "kernel_threads.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// the direction coordinates a tile holds, which stay in cache while the points of a thread pass over them
+const int TILE_VALUES = 8192;
+// the fewest and most directions of a tile
+const int MIN_TILE_DIRECTIONS = 16;
+const int MAX_TILE_DIRECTIONS = 512;
+// the points and directions whose products are kept in registers together; a tile holds a multiple of LANES
+// directions, the directions past the last one being 0
+const int POINT_BLOCK = 4;
+const int LANES = 4;
+// the multiply-adds below which the product is computed on one thread
+const double PARALLEL_WORK = 1 << 22;
+
+// the products of POINTS consecutive points, from x, with LANES directions of a tile, from f and stride apart by
+// dimension; every coordinate of a point is loaded once for LANES directions and every direction once for POINTS
+// points
+template <int POINTS>
+void multiply_block(const COORD_TYPE* x, int dim, const double* f, int stride, double product[POINTS][LANES])
+{
+	for (int r = 0; r < POINTS; r++)
+		for (int j = 0; j < LANES; j++)
+			product[r][j] = 0;
+	for (int k = 0; k < dim; k++, f += stride)
+	{
+		for (int r = 0; r < POINTS; r++)
+		{
+			double xk = x[(size_t)r * dim + k];
+			for (int j = 0; j < LANES; j++)
+				product[r][j] += xk * f[j];
+		}
+	}
+}
+
+// the products of the points [i, i + POINTS) with the directions [begin, end) of a tile into max and argmax (and
+// products)
+template <int POINTS>
+void multiply_points(const COORD_TYPE* points, int dim, int i, const double* tile, int stride, int begin, int end,
+	int m, double* max, int* argmax, double* products)
+{
+	double product[POINTS][LANES];
+	for (int lane = 0; lane < stride; lane += LANES)
+	{
+		multiply_block<POINTS>(points + (size_t)i * dim, dim, tile + lane, stride, product);
+		int count = std::min(LANES, end - begin - lane);
+		// the first of equal points is kept, as the points come in order
+		for (int r = 0; r < POINTS; r++)
+		{
+			for (int j = 0; j < count; j++)
+			{
+				int direction = begin + lane + j;
+				if (products != NULL)
+					products[(size_t)(i + r) * m + direction] = product[r][j];
+				if (product[r][j] > max[direction])
+				{
+					max[direction] = product[r][j];
+					argmax[direction] = i + r;
+				}
+			}
+		}
+	}
+}
+
+// the products of the points [first, last) with the directions [begin, end) of a tile, stored by dimension with
+// stride directions per dimension, into max and argmax (and products)
+void multiply_tile(const COORD_TYPE* points, int dim, int first, int last, const double* tile, int stride, int begin,
+	int end, int m, double* max, int* argmax, double* products)
+{
+	int i = first;
+	for (; i + POINT_BLOCK <= last; i += POINT_BLOCK)
+		multiply_points<POINT_BLOCK>(points, dim, i, tile, stride, begin, end, m, max, argmax, products);
+	for (; i < last; i++)
+		multiply_points<1>(points, dim, i, tile, stride, begin, end, m, max, argmax, products);
+}
+
+} // namespace
+
+void batch_argmax(point_set_t* p, const double* directions, int m, double* max, int* argmax, double* products)
+{
+	int n = p->numberOfPoints;
+	int dim = p->points[0]->dim;
+	if (m == 0)
+		return;
+
+	std::vector<COORD_TYPE> points((size_t)n * dim);
+	for (int i = 0; i < n; i++)
+		std::copy(p->points[i]->coord, p->points[i]->coord + dim, &points[(size_t)i * dim]);
+
+	// the directions by tiles, each stored by dimension, so that the products of a point with a tile are computed
+	// from consecutive values
+	int tile_size = std::max(MIN_TILE_DIRECTIONS, std::min(MAX_TILE_DIRECTIONS, TILE_VALUES / dim)) / LANES * LANES;
+	int tile_count = (m + tile_size - 1) / tile_size;
+	std::vector<double> tiles((size_t)tile_count * tile_size * dim, 0);
+	for (int begin = 0; begin < m; begin += tile_size)
+	{
+		int count = std::min(m, begin + tile_size) - begin;
+		int stride = (count + LANES - 1) / LANES * LANES;
+		double* tile = &tiles[(size_t)begin * dim];
+		for (int j = 0; j < count; j++)
+		{
+			for (int k = 0; k < dim; k++)
+				tile[(size_t)k * stride + j] = directions[(size_t)(begin + j) * dim + k];
+		}
+	}
+
+	int threads = 1;
+	if ((double)n * m * dim >= PARALLEL_WORK)
+		threads = std::max(1, std::min(kernel_threads(), n));
+
+	// every thread reduces its range of the points into its own maxima, which are merged in the order of the ranges
+	std::vector<std::vector<double> > maxima(threads, std::vector<double>(m, 0));
+	std::vector<std::vector<int> > argmaxima(threads, std::vector<int>(m, 0));
+	auto multiply = [&](int first, int last, int t) {
+		for (int begin = 0; begin < m; begin += tile_size)
+		{
+			int end = std::min(m, begin + tile_size);
+			int stride = (end - begin + LANES - 1) / LANES * LANES;
+			multiply_tile(&points[0], dim, first, last, &tiles[(size_t)begin * dim], stride, begin, end, m,
+				&maxima[t][0], &argmaxima[t][0], products);
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back(multiply, (long)n * t / threads, (long)n * (t + 1) / threads, t);
+	multiply(0, n / threads, 0);
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	for (int j = 0; j < m; j++)
+	{
+		max[j] = maxima[0][j];
+		argmax[j] = argmaxima[0][j];
+		for (int t = 1; t < threads; t++)
+		{
+			if (maxima[t][j] > max[j])
+			{
+				max[j] = maxima[t][j];
+				argmax[j] = argmaxima[t][j];
+			}
+		}
+	}
+}
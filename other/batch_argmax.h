@@ -0,0 +1,16 @@
+#ifndef BATCH_ARGMAX_H
+#define BATCH_ARGMAX_H
+
+#include "data_struct.h"
+
+// the best point of p for each of m directions at once, as the matrix product of the points and the directions
+// with every row of products reduced to its column maxima as it is computed
+// directions holds the m directions one after another, dim(p) coordinates each
+// max[j] is the largest inner product of a point of p with direction j, and argmax[j] the index of the first point
+// that has it, as maxPoint(p, direction j) returns it: 0 and 0 when no inner product is positive
+// products, when not null, receives the inner product of point i with direction j at products[i * m + j]
+// the products are summed over the dimensions in order, as dot_prod does; the points are split among the
+// kernel_threads() of the calling thread when there is enough work
+void batch_argmax(point_set_t* p, const double* directions, int m, double* max, int* argmax, double* products = NULL);
+
+#endif
@@ -0,0 +1,42 @@
+#include "cancellation.h"
+
+#include <chrono>
+
+namespace {
+
+struct thread_cancellation {
+	bool has_deadline = false;
+	std::chrono::steady_clock::time_point deadline;
+	const std::atomic<bool>* flag = nullptr;
+};
+
+thread_cancellation& current_cancellation()
+{
+	thread_local thread_cancellation cancellation;
+	return cancellation;
+}
+
+} // namespace
+
+void set_thread_cancellation(double seconds, const std::atomic<bool>* flag)
+{
+	thread_cancellation& cancellation = current_cancellation();
+	cancellation.has_deadline = seconds > 0;
+	if (cancellation.has_deadline)
+		cancellation.deadline = std::chrono::steady_clock::now() +
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	cancellation.flag = flag;
+}
+
+void clear_thread_cancellation()
+{
+	set_thread_cancellation(0, nullptr);
+}
+
+bool cancellation_requested()
+{
+	const thread_cancellation& cancellation = current_cancellation();
+	if (cancellation.flag != nullptr && cancellation.flag->load(std::memory_order_relaxed))
+		return true;
+	return cancellation.has_deadline && std::chrono::steady_clock::now() >= cancellation.deadline;
+}
@@ -0,0 +1,17 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+
+// cooperative cancellation of long computations running on the current thread
+// long loops poll cancellation_requested() and stop early, leaving a partial but consistent result
+
+// cancel the computations of the current thread once the deadline (in seconds from now) has passed
+// or once *flag becomes true; a non-positive deadline and a null flag disable the respective check
+void set_thread_cancellation(double seconds, const std::atomic<bool>* flag = nullptr);
+void clear_thread_cancellation();
+
+// whether the computation running on the current thread should stop
+bool cancellation_requested();
+
+#endif
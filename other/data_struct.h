@@ -10,7 +10,13 @@
 #include <iostream>
 #include <iterator>
 
+// the storage type of point coordinates; -DCOORD_FLOAT stores them in single precision,
+// while LPs, qhull and the dot products keep computing in double
+#ifdef COORD_FLOAT
+#define COORD_TYPE			float
+#else
 #define COORD_TYPE			double
+#endif
 #define DIST_TYPE			double
 #define PI					3.1415926
 #define INF					100000000
@@ -51,8 +57,6 @@
 #define RAMDOM_P 3
 #define HEURISTIC 2
 
-#define LABEL_LENGTH 150
-
 // data structure for storing points.
 typedef struct point
 {
@@ -60,7 +64,7 @@ typedef struct point
 	COORD_TYPE*	coord;
 
 	int			id;
-	char		label[LABEL_LENGTH];
+	bool		in_arena;	// allocated from a point arena, released with its scope
 	
 }	point_t;
 
@@ -69,6 +73,7 @@ typedef struct point_set
 {
 	int numberOfPoints;
 	point_t **points;
+	bool in_arena;	// allocated from a point arena, released with its scope
 }	point_set_t;
 
 // data structure for storing hyperplane.
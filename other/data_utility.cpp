@@ -2,6 +2,63 @@
 
 #include "data_utility.h"
 
+namespace {
+
+// the memory of the point arena of a thread: a list of chunks filled front to back
+struct point_arena
+{
+	std::vector<std::pair<char*, size_t> > chunks;	// memory and capacity
+	size_t chunk = 0;	// the chunk allocations are taken from
+	size_t offset = 0;	// the first free byte in that chunk
+	int scopes = 0;		// the number of open point_arena_scope
+
+	~point_arena()
+	{
+		for (size_t i = 0; i < chunks.size(); i++)
+			free(chunks[i].first);
+	}
+};
+
+const size_t ARENA_CHUNK_SIZE = 1 << 20;
+
+thread_local point_arena arena;
+
+// zeroed memory from the arena
+void* arena_alloc(size_t size)
+{
+	size = (size + 15) & ~(size_t)15;
+	while (arena.chunk < arena.chunks.size() && arena.offset + size > arena.chunks[arena.chunk].second)
+	{
+		arena.chunk++;
+		arena.offset = 0;
+	}
+	if (arena.chunk == arena.chunks.size())
+	{
+		size_t capacity = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+		arena.chunks.push_back(std::make_pair((char*)malloc(capacity), capacity));
+		arena.offset = 0;
+	}
+	void* memory = arena.chunks[arena.chunk].first + arena.offset;
+	arena.offset += size;
+	memset(memory, 0, size);
+	return memory;
+}
+
+} // namespace
+
+point_arena_scope::point_arena_scope()
+	: chunk(arena.chunk), offset(arena.offset)
+{
+	arena.scopes++;
+}
+
+point_arena_scope::~point_arena_scope()
+{
+	arena.scopes--;
+	arena.chunk = chunk;
+	arena.offset = offset;
+}
+
 
 /*
  *	Allocate memory for a point in dim-dimensional space
@@ -10,6 +67,17 @@ point_t* alloc_point( int dim)
 {
 	point_t* point_v;
 
+	if (arena.scopes > 0)
+	{
+		// the point and its coordinates in one piece
+		point_v = (point_t*)arena_alloc(sizeof(point_t) + dim * sizeof(COORD_TYPE));
+		point_v->dim = dim;
+		point_v->coord = (COORD_TYPE*)(point_v + 1);
+		point_v->id = -1;
+		point_v->in_arena = true;
+		return point_v;
+	}
+
 	point_v = ( point_t*)malloc( sizeof( point_t));
 	memset( point_v, 0, sizeof( point_t));
 
@@ -57,6 +125,12 @@ void release_point( point_t* &point_v)
 {
 	if(point_v == NULL)
 		return;
+
+	if (point_v->in_arena)
+	{
+		point_v = NULL;
+		return;
+	}
 	
 	if(point_v->coord != NULL)
 	{
@@ -103,6 +177,15 @@ point_set_t* alloc_point_set(int numberOfPoints)
 {
 	point_set_t* point_set_v;
 
+	if (arena.scopes > 0)
+	{
+		point_set_v = (point_set_t*)arena_alloc(sizeof(point_set_t) + numberOfPoints * sizeof(point_t*));
+		point_set_v->numberOfPoints = numberOfPoints;
+		point_set_v->points = (point_t**)(point_set_v + 1);
+		point_set_v->in_arena = true;
+		return point_set_v;
+	}
+
 	point_set_v = ( point_set_t*)malloc( sizeof( point_set_t));
 	memset( point_set_v, 0, sizeof( point_set_t));
 
@@ -130,6 +213,12 @@ void release_point_set(point_set_t* &point_set_v, bool clear)
 				release_point( point_set_v->points[i]);
 		}
 
+		if (point_set_v->in_arena)
+		{
+			point_set_v = NULL;
+			return;
+		}
+
 		free(point_set_v->points);
 		point_set_v->points = NULL;
 	}
@@ -24,6 +24,24 @@ void release_point_set(point_set_t* &point_set_v, bool clear);
 hyperplane_t* alloc_hyperplane(point_t* normal, double offset);
 void release_hyperplane(hyperplane_t* &hyperplane_v);
 
+// while a point_arena_scope is alive, alloc_point and alloc_point_set on the same thread take their
+// memory from a thread-local arena in one piece, release_point and release_point_set leave it alone,
+// and all of it is reclaimed when the scope ends; the arena memory is reused by later scopes
+// only open a scope where no point or point set allocated inside it outlives it
+class point_arena_scope
+{
+public:
+	point_arena_scope();
+	~point_arena_scope();
+
+	point_arena_scope(const point_arena_scope&) = delete;
+	point_arena_scope& operator=(const point_arena_scope&) = delete;
+
+private:
+	size_t chunk;
+	size_t offset;
+};
+
 // print informaiton
 void print_point(point_t* point_v);
 void print_point_set(point_set_t* point_set_v);
@@ -0,0 +1,151 @@
+#include "dimension_set.h"
+
+namespace {
+
+const int WORD_BITS = 64;
+
+int popcount(uint64_t word)
+{
+	return __builtin_popcountll(word);
+}
+
+// the position of the k-th set bit of word, counting from 0
+int select_in_word(uint64_t word, int k)
+{
+	for (int i = 0; i < k; ++i)
+		word &= word - 1;
+	return __builtin_ctzll(word);
+}
+
+} // namespace
+
+dimension_set dimension_set::range(int first, int count)
+{
+	dimension_set set;
+	for (int dim = first; dim < first + count; ++dim)
+		set.insert(dim);
+	return set;
+}
+
+bool dimension_set::contains(int dim) const
+{
+	size_t word = dim / WORD_BITS;
+	return dim >= 0 && word < words_.size() && (words_[word] >> (dim % WORD_BITS) & 1);
+}
+
+void dimension_set::insert(int dim)
+{
+	size_t word = dim / WORD_BITS;
+	if (word >= words_.size())
+		words_.resize(word + 1, 0);
+	uint64_t bit = uint64_t(1) << (dim % WORD_BITS);
+	if (!(words_[word] & bit))
+	{
+		words_[word] |= bit;
+		count_++;
+	}
+}
+
+void dimension_set::erase(int dim)
+{
+	if (!contains(dim))
+		return;
+	words_[dim / WORD_BITS] &= ~(uint64_t(1) << (dim % WORD_BITS));
+	count_--;
+	trim();
+}
+
+int dimension_set::select(int k) const
+{
+	for (size_t word = 0; word < words_.size(); ++word)
+	{
+		int bits = popcount(words_[word]);
+		if (k < bits)
+			return word * WORD_BITS + select_in_word(words_[word], k);
+		k -= bits;
+	}
+	return -1;
+}
+
+int dimension_set::rank(int dim) const
+{
+	if (dim <= 0)
+		return 0;
+	size_t last = dim / WORD_BITS;
+	int count = 0;
+	for (size_t word = 0; word < last && word < words_.size(); ++word)
+		count += popcount(words_[word]);
+	if (last < words_.size() && dim % WORD_BITS != 0)
+		count += popcount(words_[last] & ((uint64_t(1) << (dim % WORD_BITS)) - 1));
+	return count;
+}
+
+int dimension_set::next(int dim) const
+{
+	if (dim < 0)
+		dim = 0;
+	size_t word = dim / WORD_BITS;
+	if (word >= words_.size())
+		return -1;
+	uint64_t bits = words_[word] & (~uint64_t(0) << (dim % WORD_BITS));
+	while (bits == 0)
+	{
+		if (++word == words_.size())
+			return -1;
+		bits = words_[word];
+	}
+	return word * WORD_BITS + __builtin_ctzll(bits);
+}
+
+std::vector<int> dimension_set::slice(int first, int count) const
+{
+	std::vector<int> dims;
+	if (count <= 0)
+		return dims;
+	// locate the first dimension once, then walk the bits
+	for (int dim = select(first); dim != -1 && (int)dims.size() < count; dim = next(dim + 1))
+		dims.push_back(dim);
+	return dims;
+}
+
+size_t dimension_set::hash() const
+{
+	// FNV-1a over the words
+	uint64_t h = 14695981039346656037ull;
+	for (uint64_t word : words_)
+	{
+		h ^= word;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+bool dimension_set::operator==(const dimension_set& other) const
+{
+	return count_ == other.count_ && words_ == other.words_;
+}
+
+bool dimension_set::operator<(const dimension_set& other) const
+{
+	// the sequences agree up to the smallest dimension in only one of the sets; the other set continues with a
+	// larger dimension there, or it ends and is a prefix
+	size_t words = words_.size() < other.words_.size() ? words_.size() : other.words_.size();
+	for (size_t word = 0; word < words; ++word)
+	{
+		uint64_t difference = words_[word] ^ other.words_[word];
+		if (difference == 0)
+			continue;
+		int dim = word * WORD_BITS + __builtin_ctzll(difference);
+		if (contains(dim))
+			return other.next(dim) != -1;
+		return next(dim) == -1;
+	}
+	// one set is a prefix of the other
+	return words_.size() < other.words_.size();
+}
+
+void dimension_set::trim()
+{
+	while (!words_.empty() && words_.back() == 0)
+		words_.pop_back();
+}
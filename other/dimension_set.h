@@ -0,0 +1,79 @@
+#ifndef DIMENSION_SET_H
+#define DIMENSION_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// a set of dimensions stored as a bitset, with the k-th smallest dimension (select) and the number of smaller
+// dimensions (rank) found by counting the bits of the words instead of walking a tree
+// iterates, compares and orders like the std::set<int> of the same dimensions
+class dimension_set {
+public:
+	class const_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef int value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const int* pointer;
+		typedef int reference;
+
+		const_iterator(const dimension_set* set, int dim) : set_(set), dim_(dim) {}
+		int operator*() const { return dim_; }
+		const_iterator& operator++() { dim_ = set_->next(dim_ + 1); return *this; }
+		bool operator==(const const_iterator& other) const { return dim_ == other.dim_; }
+		bool operator!=(const const_iterator& other) const { return dim_ != other.dim_; }
+
+	private:
+		const dimension_set* set_;
+		int dim_;	// -1 at the end
+	};
+
+	dimension_set() : count_(0) {}
+	// the dimensions first, first+1, ..., first+count-1
+	static dimension_set range(int first, int count);
+	template <typename Iterator>
+	dimension_set(Iterator first, Iterator last) : count_(0)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	int size() const { return count_; }
+	bool empty() const { return count_ == 0; }
+	bool contains(int dim) const;
+	void insert(int dim);
+	void erase(int dim);
+
+	// the k-th smallest dimension, counting from 0; k must be below size()
+	int select(int k) const;
+	// the number of dimensions smaller than dim
+	int rank(int dim) const;
+	// the smallest dimension not below dim, -1 if there is none
+	int next(int dim) const;
+	// the dimensions of rank first, first+1, ..., first+count-1 in increasing order
+	std::vector<int> slice(int first, int count) const;
+
+	const_iterator begin() const { return const_iterator(this, next(0)); }
+	const_iterator end() const { return const_iterator(this, -1); }
+
+	size_t hash() const;
+	bool operator==(const dimension_set& other) const;
+	bool operator!=(const dimension_set& other) const { return !(*this == other); }
+	// lexicographic on the increasing dimensions, as std::set<int>
+	bool operator<(const dimension_set& other) const;
+
+private:
+	// the words up to the last nonzero one; trailing zero words are dropped so that equal sets have equal words
+	void trim();
+
+	std::vector<uint64_t> words_;
+	int count_;
+};
+
+struct dimension_set_hash {
+	size_t operator()(const dimension_set& set) const { return set.hash(); }
+};
+
+#endif
@@ -1,6 +1,124 @@
 #include "frame.h"
 
-void findExtremeRay(vector<point_t*> P, vector<int> active,  point_t* pi, point_t* sigma, int& newRay)
+// the number of rays from which frameConeFastLP tests the rays on several threads
+#define PARALLEL_RAYS 256
+
+// tests the active rays of frameConeFastLP against the current frame B, on the calling thread and on helper threads
+// a round tests the rays from a position on, in order, and ends at the first ray outside of the cone of B; the rays
+// before it are tested against the same B as in the sequential loop, so the outcomes are the same
+class ray_tester
+{
+public:
+	ray_tester(const vector<point_t*>& rays, const vector<int>& active, int helpers);
+	~ray_tester();
+
+	// the first active ray from first on that is outside of the cone of frame, or the number of rays if there is none
+	int first_outside(const vector<point_t*>& frame, int first);
+
+private:
+	void help();
+	// returns the number of LPs solved
+	long long test_rays(point_t* pi);
+
+	const vector<point_t*>& rays;
+	const vector<int>& active;
+	const vector<point_t*>* frame;
+	point_t* pi;
+	std::atomic<int> next;					// the next ray to test
+	std::atomic<int> stop;					// the first ray found outside so far
+	std::atomic<long long> helper_solves;	// the LPs of the helpers, which count them on their own threads
+	std::mutex mutex;
+	std::condition_variable start, done;
+	int round, busy;
+	bool closing;
+	vector<std::thread> threads;
+};
+
+ray_tester::ray_tester(const vector<point_t*>& rays, const vector<int>& active, int helpers)
+	: rays(rays), active(active), frame(nullptr), pi(alloc_point(rays[0]->dim)), next(0), stop(0), helper_solves(0),
+	  round(0), busy(0), closing(false)
+{
+	for(int i = 0; i < helpers; i++)
+		threads.emplace_back(&ray_tester::help, this);
+}
+
+ray_tester::~ray_tester()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	start.notify_all();
+	for(int i = 0; i < threads.size(); i++)
+		threads[i].join();
+	release_point(pi);
+}
+
+int ray_tester::first_outside(const vector<point_t*>& frame, int first)
+{
+	this->frame = &frame;
+	next = first;
+	stop = rays.size();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		round++;
+		busy = threads.size();
+	}
+	start.notify_all();
+
+	test_rays(pi);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return busy == 0; });
+	metric_add(METRIC_LP_SOLVE, helper_solves.exchange(0));
+	return stop;
+}
+
+void ray_tester::help()
+{
+	point_t* pi = alloc_point(rays[0]->dim);
+	int seen = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true)
+	{
+		start.wait(lock, [&] { return closing || round != seen; });
+		if(closing)
+			break;
+		seen = round;
+		lock.unlock();
+		helper_solves += test_rays(pi);
+		lock.lock();
+		if(--busy == 0)
+			done.notify_one();
+	}
+	lock.unlock();
+	release_point(pi);
+}
+
+long long ray_tester::test_rays(point_t* pi)
+{
+	long long solves = 0;
+	// the rays past a ray found outside are left to later rounds
+	for(int i = next++; i < stop; i = next++)
+	{
+		if(!active[i])
+			continue;
+
+		double theta;
+		solveLP(*frame, rays[i], theta, pi);
+		solves++;
+
+		double v = dot_prod(pi, rays[i]);
+		if(v > 0 && ! isZero(v))
+		{
+			int current = stop;
+			while(i < current && !stop.compare_exchange_weak(current, i));
+		}
+	}
+	return solves;
+}
+
+void findExtremeRay(const vector<point_t*>& P, const vector<int>& active,  point_t* pi, point_t* sigma, int& newRay)
 {
 	double max = -INF;
 	vector<int> U;
@@ -43,7 +161,7 @@ void findExtremeRay(vector<point_t*> P, vector<int> active,  point_t* pi, point_
 	}
 }
 
-void initial(vector<point_t*> P, vector<int>& active, int& rank, vector<int>& B, point_t*& sigma)
+void initial(const vector<point_t*>& P, vector<int>& active, int& rank, vector<int>& B, point_t*& sigma)
 {
 	int dim = P[0]->dim;
 	B.clear();
@@ -138,7 +256,9 @@ void initial(vector<point_t*> P, vector<int>& active, int& rank, vector<int>& B,
 	//print_point(sigma);
 
 	int newRay;
-	findExtremeRay(P, active, scale(-1, pi), sigma, newRay);
+	point_t* minus_pi = scale(-1, pi);
+	findExtremeRay(P, active, minus_pi, sigma, newRay);
+	release_point(minus_pi);
 	B.push_back(newRay);
 	active[newRay] = 0;
 
@@ -151,7 +271,7 @@ void initial(vector<point_t*> P, vector<int>& active, int& rank, vector<int>& B,
 }
 
 // frame compuatation (all at once)
-void frameConeFastLP(vector<point_t*> rays, vector<int>& B)
+void frameConeFastLP(const vector<point_t*>& rays, vector<int>& B)
 {
 	int dim = rays[0]->dim;
 
@@ -161,19 +281,35 @@ void frameConeFastLP(vector<point_t*> rays, vector<int>& B)
 	point_t* pi = alloc_point(dim);
 
 	initial(rays, active, rank, B, sigma);
+
+	std::unique_ptr<ray_tester> tester;
+	int threads = kernel_threads();
+	if(threads > 1 && rays.size() >= PARALLEL_RAYS)
+		tester.reset(new ray_tester(rays, active, threads - 1));
 	
+	// the rays of B
+	vector<point_t*> frame;
+	for(int j = 0; j < B.size(); j++)
+		frame.push_back(rays[B[j]]);
+
 	for(int i = 0; i < rays.size(); )
 	{
+		if(tester)
+		{
+			// the active rays before the first one outside are inside; that one is tested again below for its pi
+			int outside = tester->first_outside(frame, i);
+			for(; i < outside; i++)
+				active[i] = 0;
+			if(i == rays.size())
+				break;
+		}
+
 		if(active[i])
 		{
 			//printIndex(B);
 
 			point_t* b = rays[i];
 
-			vector<point_t*> frame;
-			for(int j = 0; j < B.size(); j++)
-				frame.push_back(rays[B[j]]);
-
 			double theta;
 			solveLP(frame, b, theta, pi);
 
@@ -193,6 +329,7 @@ void frameConeFastLP(vector<point_t*> rays, vector<int>& B)
 				findExtremeRay(rays, active, pi, sigma, newRay);
 
 				B.push_back(newRay);
+				frame.push_back(rays[newRay]);
 				active[newRay] = 0;
 			}
 			else
@@ -208,10 +345,11 @@ void frameConeFastLP(vector<point_t*> rays, vector<int>& B)
 	}
 
 	release_point(pi);
+	release_point(sigma);
 }
 
 // parital frame compuatation (only s)
-void partialConeFastLP(vector<point_t*> rays, vector<int>& B, int s)
+void partialConeFastLP(const vector<point_t*>& rays, vector<int>& B, int s)
 {
 	int dim = rays[0]->dim;
 
@@ -3,14 +3,23 @@
 
 #include "data_struct.h"
 #include "data_utility.h"
+#include "kernel_threads.h"
 #include "lp.h"
+#include "metrics.h"
 #include "operation.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 // frame compuatation (all at once)
-void frameConeFastLP(vector<point_t*> rays, vector<int>& idxs);
+// with many rays, the rays are tested against the frame on the kernel_threads() of the calling thread
+void frameConeFastLP(const vector<point_t*>& rays, vector<int>& idxs);
 
 // parital frame compuatation (only s)
-void partialConeFastLP(vector<point_t*> rays, vector<int>& B, int s);
+void partialConeFastLP(const vector<point_t*>& rays, vector<int>& B, int s);
 
 // frame compuatation (all at once) - naive implementation
 void frameConeLP(std::vector<point_t*> rays, std::vector<int>& idxs);
@@ -0,0 +1,145 @@
+#include "hull_vertices.h"
+#include "data_utility.h"
+#include "lp.h"
+#include "mips_tree.h"
+#include "operation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// how much a point may lose to the best point in its best direction and still count as tied with it
+const double TIE_TOLERANCE = 1e-9;
+
+// the fewest points per thread
+const int POINTS_PER_THREAD = 64;
+
+// 0: not tested, 1: a vertex, 2: not a vertex
+typedef std::unique_ptr<std::atomic<char>[]> vertex_marks;
+
+// whether pt has the largest utility in p for some utility vector
+// the LP finds the direction in which pt is best against the points in beating; if another point of p is better
+// there, it joins beating and the LP is solved again. That point is the best one in a direction, so it is marked as
+// a vertex, which spares its own LPs
+bool is_hull_vertex(const mips_tree& tree, point_t* pt, const std::vector<point_t*>& axis_best,
+	const std::unordered_map<point_t*, int>& index, const vertex_marks& vertex)
+{
+	int dim = pt->dim;
+
+	// a point without a positive coordinate has utility 0 only
+	bool positive = false;
+	for (int j = 0; j < dim && !positive; j++)
+		positive = pt->coord[j] > 0;
+	if (!positive)
+		return false;
+
+	std::vector<point_t*> beating;
+	for (point_t* q : axis_best)
+	{
+		if (q != pt)
+			beating.push_back(q);
+	}
+
+	std::vector<double> direction(dim);
+	double* v = &direction[0];
+	while (true)
+	{
+		point_set_t set;
+		set.numberOfPoints = beating.size();
+		set.points = &beating[0];
+		set.in_arena = false;
+
+		// pt.v = 1, and no point in beating has more than 1 - x
+		double x = worstDirection(&set, pt, v);
+		if (x < -TIE_TOLERANCE)
+			return false;
+
+		point_t* best = tree.max_point(v);
+		if (dot_prod(best, v) <= dot_prod(pt, v) + TIE_TOLERANCE)
+			return true;
+		// the LP already has it, so it is better only by the rounding of the LP
+		if (std::find(beating.begin(), beating.end(), best) != beating.end())
+			return true;
+		beating.push_back(best);
+		vertex[index.at(best)] = 1;
+	}
+}
+
+} // namespace
+
+point_set_t* hull_vertices(point_set_t* p)
+{
+	// a dominated point is never better than the point dominating it, which saves the LPs of most of the points
+	point_set_t* skyline = skyline_point(p);
+	int n = skyline->numberOfPoints;
+	int dim = skyline->points[0]->dim;
+
+	vertex_marks vertex(new std::atomic<char>[n]);
+	std::unordered_map<point_t*, int> index;
+	for (int i = 0; i < n; i++)
+	{
+		vertex[i] = 0;
+		index[skyline->points[i]] = i;
+	}
+
+	// the best points for the unit vectors are vertices, and the first points the others are tested against
+	std::vector<int> best(dim, 0);
+	for (int i = 1; i < n; i++)
+	{
+		for (int j = 0; j < dim; j++)
+		{
+			if (skyline->points[i]->coord[j] > skyline->points[best[j]]->coord[j])
+				best[j] = i;
+		}
+	}
+	std::vector<point_t*> axis_best;
+	for (int j = 0; j < dim; j++)
+	{
+		if (vertex[best[j]] == 0)
+			axis_best.push_back(skyline->points[best[j]]);
+		vertex[best[j]] = 1;
+	}
+
+	mips_tree tree(skyline);
+	std::atomic<int> next(0);
+	auto test = [&]() {
+		for (int i = next++; i < n; i = next++)
+		{
+			if (vertex[i] != 0)
+				continue;
+			// another thread may have found it best in a direction meanwhile, which is not taken back
+			char untested = 0;
+			if (is_hull_vertex(tree, skyline->points[i], axis_best, index, vertex))
+				vertex[i] = 1;
+			else
+				vertex[i].compare_exchange_strong(untested, 2);
+		}
+	};
+
+	int threads = std::max(1, std::min((int)std::thread::hardware_concurrency(), n / POINTS_PER_THREAD));
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back(test);
+	test();
+	for (auto& worker : workers)
+		worker.join();
+
+	// skyline_point does not keep the order of p
+	std::vector<point_t*> vertices;
+	for (int i = 0; i < p->numberOfPoints; i++)
+	{
+		auto found = index.find(p->points[i]);
+		if (found != index.end() && vertex[found->second] == 1)
+			vertices.push_back(p->points[i]);
+	}
+	release_point_set(skyline, false);
+
+	point_set_t* result = alloc_point_set(vertices.size());
+	std::copy(vertices.begin(), vertices.end(), result->points);
+	return result;
+}
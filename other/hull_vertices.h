@@ -0,0 +1,15 @@
+#ifndef HULL_VERTICES_H
+#define HULL_VERTICES_H
+
+#include "data_struct.h"
+
+// the skyline points of p that have the largest utility in p for some utility vector u >= 0, u != 0: the vertices of
+// the upper convex hull of p in the non-negative orthant, and the skyline points tied with them on its faces
+// for every such u, maxPoint over the result has the same utility as maxPoint over p, so the maximum regret ratio
+// of a set, and the best point for a utility vector, can be found on the result
+// no hull is built: each skyline point is tested with the worstDirection LP against the points that beat it in the
+// directions of the earlier LPs, which a mips_tree of the skyline finds, on one thread per core
+// the result shares the points of p, in the order of p
+point_set_t* hull_vertices(point_set_t* p);
+
+#endif
@@ -0,0 +1,35 @@
+#include "kernel_threads.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+int& current_kernel_threads()
+{
+	thread_local int threads = 0;
+	return threads;
+}
+
+int cores()
+{
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+} // namespace
+
+void set_thread_kernel_threads(int threads)
+{
+	current_kernel_threads() = std::max(0, threads);
+}
+
+int kernel_threads()
+{
+	int threads = current_kernel_threads();
+	return threads > 0 ? threads : cores();
+}
+
+int kernel_threads_per_worker(int workers)
+{
+	return std::max(1, cores() / std::max(1, workers));
+}
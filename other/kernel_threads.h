@@ -0,0 +1,16 @@
+#ifndef KERNEL_THREADS_H
+#define KERNEL_THREADS_H
+
+// the threads the parallel kernels (frameConeFastLP, batch_argmax, regret_matrix) of the current thread may use
+// a pool of workers that each run kernels divides the cores between them, instead of every kernel taking them all
+
+// let the kernels of the current thread use up to threads threads, itself included; 0 restores one per core
+void set_thread_kernel_threads(int threads);
+
+// the threads a kernel of the current thread may use, at least 1
+int kernel_threads();
+
+// the budget of each of workers threads that share the cores
+int kernel_threads_per_worker(int workers);
+
+#endif
@@ -1,6 +1,9 @@
 //#include "stdAfx.h"
 
 #include "lp.h"
+#include "metrics.h"
+#include "batch_argmax.h"
+#include "mips_tree.h"
 #include <set>
 #include <ctime>
 #include <vector>
@@ -8,9 +11,21 @@
 #include <cstdio>
 #include <cmath>
 #include <random>
+#include <algorithm>
+#include <memory>
 
 //#define DEBUG_LP
 
+// the worst directions of evaluateLP whose best points are found together
+const int DIRECTION_BATCH = 1024;
+// the dimensions up to which, and the points from which, evaluateLP finds the best points of p with a ball tree,
+// whose balls then skip most of p in every direction; elsewhere the blocked product of batch_argmax is faster
+const int MIPS_TREE_MAX_DIM = 6;
+const int MIPS_TREE_MIN_POINTS = 4096;
+// the largest and smallest spread of the log-normal perturbations of estimate_mrr
+const double MAX_SPREAD = 1.0;
+const double MIN_SPREAD = 1.0 / 1024;
+
 // Takes an array of points s (of size N) and  a point pt and returns
 // the direction in which pt has the worst regret ratio (in array v)
 // as well as this regret ratio itself. 
@@ -37,6 +52,7 @@
 // Use LP to check whehter a point pt is a conical combination of the vectors in ExRays
 bool insideCone(std::vector<point_t*> ExRays, point_t* pt)
 {
+	metric_add(METRIC_LP_INSIDE_CONE);
 	int M = ExRays.size();
 	int D = pt->dim;
 
@@ -123,6 +139,7 @@ bool insideCone(std::vector<point_t*> ExRays, point_t* pt)
 // Use LP to find a feasible point of the half sapce intersection (used later in Qhull for half space intersection)
 point_t* find_feasible(std::vector<hyperplane_t*> hyperplane)
 {
+	metric_add(METRIC_LP_FIND_FEASIBLE);
 	int M = hyperplane.size();
 	int D = hyperplane[0]->normal->dim;
 
@@ -247,6 +264,7 @@ point_t* find_feasible(std::vector<hyperplane_t*> hyperplane)
 // solve the LP in frame computation
 void solveLP(std::vector<point_t*> B, point_t* b, double& theta, point_t* & pi)
 {
+	metric_add(METRIC_LP_SOLVE);
 	int M = B.size()+1;
 	int D = b->dim;
 
@@ -381,6 +399,174 @@ void solveLP(std::vector<point_t*> B, point_t* b, double& theta, point_t* & pi)
 	release_point(mean);
 }
 
+/* We solve the following LP with col variables u[1], ..., u[D] and row variables q_1 ... q_M, s
+
+   Min c[1]u[1] + ... + c[D]u[D]
+   s.t. v_i[1]u[1] + ... + v_i[D]u[D] = q_i   for the extreme vectors v_1 ... v_M
+        u[1] + ... + u[D] = s
+   variables have the following bounds
+       0 <= u[j] < infty
+       -infty < q_i <= 0
+       s = 1
+*/
+bool utility_range_min(const std::vector<point_t*>& ext_vec, point_t* c, double& value, point_t* u_min)
+{
+	metric_add(METRIC_LP_UTILITY_RANGE);
+	int M = ext_vec.size();
+	int D = c->dim;
+
+	std::vector<int> ia(1 + D * (M + 1));
+	std::vector<int> ja(1 + D * (M + 1));
+	std::vector<double> ar(1 + D * (M + 1));
+
+	glp_prob *lp = glp_create_prob();
+	glp_set_prob_name(lp, "utility_range_min");
+	glp_set_obj_dir(lp, GLP_MIN);
+
+	glp_add_rows(lp, M + 1);
+	for (int i = 1; i <= M; i++)
+		glp_set_row_bnds(lp, i, GLP_UP, 0.0, 0.0); // q_i <= 0
+	glp_set_row_bnds(lp, M + 1, GLP_FX, 1.0, 1.0); // s = 1
+
+	glp_add_cols(lp, D);
+	for (int j = 1; j <= D; j++)
+	{
+		glp_set_col_bnds(lp, j, GLP_LO, 0.0, 0.0); // 0 <= u[j] < infty
+		glp_set_obj_coef(lp, j, c->coord[j - 1]);
+	}
+
+	int counter = 1;
+	for (int i = 1; i <= M + 1; i++)
+	{
+		for (int j = 1; j <= D; j++)
+		{
+			ia[counter] = i; ja[counter] = j;
+			ar[counter++] = i <= M ? ext_vec[i - 1]->coord[j - 1] : 1;
+		}
+	}
+	glp_load_matrix(lp, counter - 1, ia.data(), ja.data(), ar.data());
+
+	glp_smcp parm;
+	glp_init_smcp(&parm);
+	parm.msg_lev = GLP_MSG_OFF; // turn off all message by glp_simplex
+	glp_simplex(lp, &parm);
+
+	bool feasible = glp_get_status(lp) == GLP_OPT;
+	value = feasible ? glp_get_obj_val(lp) : 0;
+	if (feasible && u_min != NULL)
+	{
+		for (int j = 0; j < D; j++)
+			u_min->coord[j] = glp_get_col_prim(lp, j + 1);
+	}
+
+	glp_delete_prob(lp); // clean up
+	return feasible;
+}
+
+/* We solve the following LP with col variables u[1], ..., u[D], r and row variables q_1 ... q_M, w_1 ... w_D, s,
+   where |v_i'| is the length of v_i projected onto the hyperplane sum(u) = 0, and e = sqrt(1 - 1/D) that of a unit vector
+
+   Max r
+   s.t. v_i[1]u[1] + ... + v_i[D]u[D] + |v_i'| r = q_i   for the extreme vectors v_1 ... v_M
+        u[j] - e r = w_j
+        u[1] + ... + u[D] = s
+   variables have the following bounds
+       0 <= u[j] < infty
+       0 <= r < infty
+       -infty < q_i <= 0
+       0 <= w_j < infty
+       s = 1
+*/
+double utility_range_center(const std::vector<point_t*>& ext_vec, point_t* center)
+{
+	metric_add(METRIC_LP_UTILITY_RANGE);
+	int M = ext_vec.size();
+	int D = center->dim;
+	int rows = M + D + 1;
+
+	std::vector<int> ia(1 + (D + 1) * rows);
+	std::vector<int> ja(1 + (D + 1) * rows);
+	std::vector<double> ar(1 + (D + 1) * rows);
+
+	glp_prob *lp = glp_create_prob();
+	glp_set_prob_name(lp, "utility_range_center");
+	glp_set_obj_dir(lp, GLP_MAX);
+
+	glp_add_rows(lp, rows);
+	for (int i = 1; i <= M; i++)
+		glp_set_row_bnds(lp, i, GLP_UP, 0.0, 0.0); // q_i <= 0
+	for (int i = M + 1; i <= M + D; i++)
+		glp_set_row_bnds(lp, i, GLP_LO, 0.0, 0.0); // w_j >= 0
+	glp_set_row_bnds(lp, rows, GLP_FX, 1.0, 1.0); // s = 1
+
+	glp_add_cols(lp, D + 1);
+	for (int j = 1; j <= D; j++)
+	{
+		glp_set_col_bnds(lp, j, GLP_LO, 0.0, 0.0); // 0 <= u[j] < infty, which the rows w_j imply
+		glp_set_obj_coef(lp, j, 0.0);
+	}
+	glp_set_col_bnds(lp, D + 1, GLP_LO, 0.0, 0.0); // 0 <= r < infty
+	glp_set_obj_coef(lp, D + 1, 1.0);
+
+	int counter = 1;
+	for (int i = 1; i <= M; i++)
+	{
+		point_t* v = ext_vec[i - 1];
+		double sum = 0, length = 0;
+		for (int j = 0; j < D; j++)
+			sum += v->coord[j];
+		for (int j = 0; j < D; j++)
+			length += (v->coord[j] - sum / D) * (v->coord[j] - sum / D);
+		for (int j = 1; j <= D; j++)
+		{
+			ia[counter] = i; ja[counter] = j;
+			ar[counter++] = v->coord[j - 1];
+		}
+		ia[counter] = i; ja[counter] = D + 1;
+		ar[counter++] = sqrt(length);
+	}
+	for (int i = 1; i <= D; i++)
+	{
+		ia[counter] = M + i; ja[counter] = i;
+		ar[counter++] = 1;
+		ia[counter] = M + i; ja[counter] = D + 1;
+		ar[counter++] = -sqrt(1 - 1.0 / D);
+	}
+	for (int j = 1; j <= D; j++)
+	{
+		ia[counter] = rows; ja[counter] = j;
+		ar[counter++] = 1;
+	}
+	glp_load_matrix(lp, counter - 1, ia.data(), ja.data(), ar.data());
+
+	glp_smcp parm;
+	glp_init_smcp(&parm);
+	parm.msg_lev = GLP_MSG_OFF; // turn off all message by glp_simplex
+	glp_simplex(lp, &parm);
+
+	double radius = -1;
+	if (glp_get_status(lp) == GLP_OPT)
+	{
+		radius = glp_get_obj_val(lp);
+		for (int j = 0; j < D; j++)
+			center->coord[j] = glp_get_col_prim(lp, j + 1);
+	}
+	glp_delete_prob(lp); // clean up
+
+	if (radius < 0)
+	{
+		// the simplex may give up on a thin R, so take any utility vector of R
+		point_t* zero = alloc_point(D);
+		for (int j = 0; j < D; j++)
+			zero->coord[j] = 0;
+		double value;
+		if (utility_range_min(ext_vec, zero, value, center))
+			radius = 0;
+		release_point(zero);
+	}
+	return radius;
+}
+
 //#define DEBUG_LP
 
 // Takes an array of points s (of size N) and  a point pt and returns
@@ -407,6 +593,7 @@ void solveLP(std::vector<point_t*> B, point_t* b, double& theta, point_t* & pi)
 
 double worstDirection(point_set_t *s, point_t* pt, double* &v)
 {
+	metric_add(METRIC_LP_WORST_DIRECTION);
 	int K = s->numberOfPoints;
 	int D = pt->dim;
 
@@ -537,6 +724,7 @@ double worstDirection(point_set_t *s, point_t* pt, double* &v)
 }    
 double worstDirection(int index, point_set_t *s, point_t* pt, double* &v)
 {
+	metric_add(METRIC_LP_WORST_DIRECTION);
 	int K = index;
 	int D = pt->dim;
 
@@ -667,6 +855,7 @@ double worstDirection(int index, point_set_t *s, point_t* pt, double* &v)
 }    
 double worstDirection(int index, point_set_t *s, point_t* pt, float* &v)
 {
+	metric_add(METRIC_LP_WORST_DIRECTION);
 	int K = index;
 	int D = pt->dim;
 
@@ -921,6 +1110,31 @@ void test2(){
     printf("v=%lf %lf\n", v[0], v[1]); 
 }
 
+// the ball tree of p for evaluateLP, or null where batch_argmax is faster
+std::unique_ptr<mips_tree> evaluation_tree(point_set_t* p)
+{
+	if (p->points[0]->dim > MIPS_TREE_MAX_DIM || p->numberOfPoints < MIPS_TREE_MIN_POINTS)
+		return std::unique_ptr<mips_tree>();
+	return std::unique_ptr<mips_tree>(new mips_tree(p));
+}
+
+// the best points of p in count directions, as batch_argmax finds them, with the tree of p if it is not null
+void best_points(point_set_t* p, const mips_tree* tree, double* directions, int count, double* max, int* argmax)
+{
+	if (tree == NULL)
+	{
+		batch_argmax(p, directions, count, max, argmax);
+		return;
+	}
+	int D = p->points[0]->dim;
+	for (int i = 0; i < count; ++i)
+	{
+		double* v = directions + (size_t)i * D;
+		argmax[i] = tree->max_index(v);
+		max[i] = std::max(0.0, dot_prod(p->points[argmax[i]], v));
+	}
+}
+
 /*
 * Compute the MRR of a given set of points
 */
@@ -932,41 +1146,92 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE)
 
 	int i, j;
 	double maxRegret = 0.0, maxK, maxN;
-	double* v = new double[D];
     double min_dot = 1;
 
-	for (i = 0; i < N; ++i)
+	// the worst directions of a batch of points, and the best points of p and S in them
+	std::vector<double> directions((size_t)DIRECTION_BATCH * D);
+	std::vector<double> bestN(DIRECTION_BATCH), bestK(DIRECTION_BATCH);
+	std::vector<int> argmaxN(DIRECTION_BATCH), argmaxK(DIRECTION_BATCH);
+	std::unique_ptr<mips_tree> tree = evaluation_tree(p);
+
+	for (int first = 0; first < N; first += DIRECTION_BATCH)
 	{
-		// obtain the worst utility vector v
-		worstDirection(S, p->points[i], v);
+		int count = std::min(N, first + DIRECTION_BATCH) - first;
+		for (i = 0; i < count; ++i)
+		{
+			// obtain the worst utility vector v
+			double* v = &directions[(size_t)i * D];
+			worstDirection(S, p->points[first + i], v);
+		}
+		best_points(p, tree.get(), &directions[0], count, &bestN[0], &argmaxN[0]);
+		batch_argmax(S, &directions[0], count, &bestK[0], &argmaxK[0]);
 
-		maxN = dot_prod(maxPoint(p, v), v);
-		maxK = dot_prod(maxPoint(S, v), v);
+		for (i = 0; i < count; ++i)
+		{
+			double* v = &directions[(size_t)i * D];
+			maxN = dot_prod(p->points[argmaxN[i]], v);
+			maxK = dot_prod(S->points[argmaxK[i]], v);
 
-		if (1.0 - maxK / maxN > maxRegret)
-			maxRegret = 1.0 - maxK / maxN;
-        
-        // normalize v to be unit vector
-        // double norm_v = 0.0;
-        // for (int k = 0; k < D; ++k){
-        //     norm_v += v[k] * v[k];
-        // }
-        // norm_v = sqrt(norm_v);
-        // for (int k = 0; k < D; ++k){
-        //     v[k] = v[k] / norm_v;
-        // }
-        //check if the norm of point is zero
-        // double dot = dot_prod(p->points[i], p->points[i]);
-        // if (dot < 0.0000000001) printf("point %d has zero norm\n", i);
+			if (1.0 - maxK / maxN > maxRegret)
+				maxRegret = 1.0 - maxK / maxN;
+		}
 	}
 
 	if (VERBOSE)
 		printf("LP max regret ratio = %lf\n", maxRegret);
 
-	delete[]v;
 	return maxRegret;
 }
 
+/*
+* Check whether the MRR of S is at most eps, solving the LPs of the points that may exceed it only
+*/
+bool mrr_at_most(point_set_t *p, point_set_t* S, double eps, int* lp_count)
+{
+	int D = p->points[0]->dim;
+	int N = p->numberOfPoints;
+	int K = S->numberOfPoints;
+
+	// u.s >= min_k (s[k] / pt[k]) u.pt for every utility vector u, so the regret ratio of S for pt is at most
+	// 1 - max_s min_k s[k] / pt[k]; the points whose bound exceeds eps are kept, the largest bound first
+	std::vector<std::pair<double, int> > bounds;
+	for (int i = 0; i < N; ++i)
+	{
+		COORD_TYPE* x = p->points[i]->coord;
+		double best = 0;
+		for (int j = 0; j < K && 1 - best > eps; ++j)
+		{
+			COORD_TYPE* s = S->points[j]->coord;
+			double ratio = INF;
+			for (int k = 0; k < D && ratio > best; ++k)
+			{
+				if (x[k] > 0)
+					ratio = std::min(ratio, (double)s[k] / x[k]);
+			}
+			best = std::max(best, ratio);
+		}
+		if (1 - best > eps)
+			bounds.push_back(std::make_pair(1 - best, i));
+	}
+	std::sort(bounds.begin(), bounds.end(), std::greater<std::pair<double, int> >());
+
+	// the first point whose worst direction exceeds eps decides; the points left after the last have bounds below eps
+	bool at_most = true;
+	int lps = 0;
+	double* v = new double[D];
+	for (size_t b = 0; b < bounds.size() && at_most; ++b)
+	{
+		lps++;
+		if (worstDirection(S, p->points[bounds[b].second], v) > eps)
+			at_most = false;
+	}
+	delete[] v;
+
+	if (lp_count != NULL)
+		*lp_count = lps;
+	return at_most;
+}
+
 double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, point_t* u){
     if (p == nullptr || S == nullptr || u == nullptr) {
         printf("Error: evaluateLP called with null parameters\n");
@@ -999,6 +1264,164 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, point_t* u){
 	return maxRegret;
 }
 
+double evaluateLP(point_set_t* S, int VERBOSE, point_t* u, double max_utility){
+    if (S == nullptr || u == nullptr) {
+        printf("Error: evaluateLP called with null parameters\n");
+        return -1.0;
+    }
+
+    double* v = new double[u->dim];
+    for (int i = 0; i < u->dim; ++i){
+        v[i] = u->coord[i];
+    }
+    point_t* maxPointS = maxPoint(S, v);
+    delete[]v;
+    if (maxPointS == nullptr) {
+        printf("Error: maxPoint returned null in evaluateLP\n");
+        return -1.0;
+    }
+
+    double maxRegret = 1.0 - dot_prod(maxPointS, u) / max_utility;
+    if (VERBOSE)
+        printf("regret ratio based on ground truth: %lf\n", maxRegret);
+    return maxRegret;
+}
+
+std::vector<double> max_utilities(point_set_t* p, point_set_t* U)
+{
+	int m = U->numberOfPoints;
+	if (m == 0)
+		return std::vector<double>();
+	int D = U->points[0]->dim;
+
+	std::vector<double> directions((size_t)m * D);
+	for (int j = 0; j < m; ++j)
+		std::copy(U->points[j]->coord, U->points[j]->coord + D, &directions[(size_t)j * D]);
+	std::vector<double> best(m);
+	std::vector<int> argmax(m);
+	batch_argmax(p, &directions[0], m, &best[0], &argmax[0]);
+
+	// the utility of the best point as the single vector evaluation computes it
+	for (int j = 0; j < m; ++j)
+		best[j] = dot_prod(p->points[argmax[j]], U->points[j]);
+	return best;
+}
+
+mrr_estimate estimate_mrr(point_set_t *p, point_set_t* S, int VERBOSE, int d_prime, double delta, double tolerance,
+	int max_samples)
+{
+	int D = p->points[0]->dim;
+	std::mt19937& generator = thread_rand_generator();
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::exponential_distribution<double> exponential(1.0);
+	std::normal_distribution<double> normal(0.0, 1.0);
+
+	mrr_estimate estimate;
+	estimate.mrr = 0;
+	estimate.samples = 0;
+	double previous = 0;
+	int target = std::min(DIRECTION_BATCH, max_samples);
+	std::vector<int> indices(D);
+	// every batch holds samples of the distribution and as many perturbations of the worst utility vector so far,
+	// which climb the peak of the regret ratio that the samples only approach
+	std::vector<double> worst;
+	double spread = MAX_SPREAD;
+	point_set_t* U = alloc_point_set(2 * DIRECTION_BATCH);
+	for (int j = 0; j < 2 * DIRECTION_BATCH; ++j)
+		U->points[j] = alloc_point(D);
+
+	while (true)
+	{
+		int count = std::min(DIRECTION_BATCH, target - estimate.samples);
+		int local = worst.empty() ? 0 : count;
+		U->numberOfPoints = count + local;
+		for (int j = 0; j < U->numberOfPoints; ++j)
+		{
+			COORD_TYPE* u = U->points[j]->coord;
+			double sum = 0;
+			if (j >= count)
+			{
+				// log-normal factors keep the zero weights of the worst vector
+				for (int k = 0; k < D; ++k)
+					sum += u[k] = worst[k] * exp(spread * normal(generator));
+			}
+			else if (d_prime <= 0)
+			{
+				// normalized exponentials are uniform on the simplex
+				for (int k = 0; k < D; ++k)
+					sum += u[k] = exponential(generator);
+			}
+			else
+			{
+				// d_prime distinct dimensions with uniform weights, as generate_sparse_utility
+				for (int k = 0; k < D; ++k)
+				{
+					u[k] = 0;
+					indices[k] = k;
+				}
+				for (int k = 0; k < std::min(d_prime, D); ++k)
+				{
+					std::uniform_int_distribution<int> pick(k, D - 1);
+					std::swap(indices[k], indices[pick(generator)]);
+					sum += u[indices[k]] = uniform(generator);
+				}
+			}
+			for (int k = 0; k < D; ++k)
+				u[k] /= sum;
+		}
+
+		std::vector<double> regret = evaluateLP(p, S, 0, U);
+		int best = -1;
+		for (int j = 0; j < U->numberOfPoints; ++j)
+		{
+			if (regret[j] > estimate.mrr)
+			{
+				estimate.mrr = regret[j];
+				best = j;
+			}
+		}
+		if (best >= 0)
+			worst.assign(U->points[best]->coord, U->points[best]->coord + D);
+		// finer perturbations once the coarse ones stop finding worse vectors, and coarse ones again after the finest
+		if (local > 0 && best < count)
+			spread = spread / 2 < MIN_SPREAD ? MAX_SPREAD : spread / 2;
+		estimate.samples += count;
+
+		if (estimate.samples < target)
+			continue;
+		if (estimate.samples > DIRECTION_BATCH && estimate.mrr - previous <= tolerance)
+			break;
+		if (target >= max_samples)
+			break;
+		previous = estimate.mrr;
+		target = (int)std::min((long)max_samples, 2L * target);
+	}
+	U->numberOfPoints = 2 * DIRECTION_BATCH;
+	release_point_set(U, true);
+
+	// a probability mass above the estimate of more than ln(1 / delta) / samples is missed by all the samples of the
+	// distribution with probability at most delta
+	estimate.mass = std::min(1.0, log(1 / delta) / estimate.samples);
+	if (VERBOSE)
+		printf("MC max regret ratio = %lf over %d samples\n", estimate.mrr, estimate.samples);
+	return estimate;
+}
+
+std::vector<double> evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, point_set_t* U)
+{
+	std::vector<double> maxN = max_utilities(p, U);
+	std::vector<double> maxK = max_utilities(S, U);
+
+	std::vector<double> regret(U->numberOfPoints);
+	for (int j = 0; j < U->numberOfPoints; ++j)
+	{
+		regret[j] = 1.0 - maxK[j] / maxN[j];
+		if (VERBOSE)
+			printf("regret ratio based on ground truth: %lf\n", regret[j]);
+	}
+	return regret;
+}
+
 double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<int> final_dimensions, int test_rounds)//use random sampling
 {
     int D = p->points[0]->dim;
@@ -1011,8 +1434,11 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<i
     int round = test_rounds;
     // keep a list of mrr for each round to compute the average
     std::vector<double> mrr_list;
-    double* v = new double[d];
     double* inspect_v = new double[D];
+    // the worst directions of a batch of points, and the best points of P_prime and S_prime in them
+    std::vector<double> directions((size_t)DIRECTION_BATCH * d);
+    std::vector<double> bestN(DIRECTION_BATCH), bestK(DIRECTION_BATCH);
+    std::vector<int> argmaxN(DIRECTION_BATCH), argmaxK(DIRECTION_BATCH);
 
     // Convert final_dimensions set to vector for easier indexing
     std::vector<int> all_dims(final_dimensions.begin(), final_dimensions.end());
@@ -1023,6 +1449,8 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<i
     std::uniform_int_distribution<int> distribution(0, all_dims.size()-1);
 
     for (i = 0; i < round; ++i){
+        // the projected sets of a round are released with the round
+        point_arena_scope scope;
         // Randomly select d dimensions from final_dimensions
         std::set<int> selected_dimensions;
         while (selected_dimensions.size() < d){
@@ -1051,37 +1479,47 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<i
         }
 
         double maxRegret_round = 0.0;
+        std::unique_ptr<mips_tree> tree = evaluation_tree(P_prime);
 
-        // Find worst direction for each point
-        for (j = 0; j < N; ++j){
-            worstDirection(S_prime, P_prime->points[j], v);
-            
-            // Normalize v to unit vector
-            double norm_v = 0.0;
-            for (int k = 0; k < d; ++k){
-                norm_v += v[k] * v[k];
-            }
-            norm_v = sqrt(norm_v);
-            for (int k = 0; k < d; ++k){
-                v[k] = v[k] / norm_v;
+        // Find worst direction for each point, and the best points of P_prime and S_prime in a batch of them at once
+        for (int first = 0; first < N; first += DIRECTION_BATCH){
+            int count = std::min(N, first + DIRECTION_BATCH) - first;
+            for (j = 0; j < count; ++j){
+                double* v = &directions[(size_t)j * d];
+                worstDirection(S_prime, P_prime->points[first + j], v);
+
+                // Normalize v to unit vector
+                double norm_v = 0.0;
+                for (int k = 0; k < d; ++k){
+                    norm_v += v[k] * v[k];
+                }
+                norm_v = sqrt(norm_v);
+                for (int k = 0; k < d; ++k){
+                    v[k] = v[k] / norm_v;
+                }
             }
+            best_points(P_prime, tree.get(), &directions[0], count, &bestN[0], &argmaxN[0]);
+            batch_argmax(S_prime, &directions[0], count, &bestK[0], &argmaxK[0]);
 
-            maxN = dot_prod(maxPoint(P_prime, v), v);
-            maxK = dot_prod(maxPoint(S_prime, v), v);
+            for (j = 0; j < count; ++j){
+                double* v = &directions[(size_t)j * d];
+                maxN = dot_prod(P_prime->points[argmaxN[j]], v);
+                maxK = dot_prod(S_prime->points[argmaxK[j]], v);
 
-            if (1.0 - maxK / maxN > maxRegret_round){
-                maxRegret_round = 1.0 - maxK / maxN;
-            }
-            
-            if (1.0 - maxK / maxN > maxRegret){
-                maxRegret = 1.0 - maxK / maxN;
-                // Reset inspect_v
-                for (int k = 0; k < D; ++k){
-                    inspect_v[k] = 0;
+                if (1.0 - maxK / maxN > maxRegret_round){
+                    maxRegret_round = 1.0 - maxK / maxN;
                 }
-                // Map reduced dimensions back to original space
-                for (int k = 0; k < d; ++k){
-                    inspect_v[dimension_indices[k]] = v[k];
+
+                if (1.0 - maxK / maxN > maxRegret){
+                    maxRegret = 1.0 - maxK / maxN;
+                    // Reset inspect_v
+                    for (int k = 0; k < D; ++k){
+                        inspect_v[k] = 0;
+                    }
+                    // Map reduced dimensions back to original space
+                    for (int k = 0; k < d; ++k){
+                        inspect_v[dimension_indices[k]] = v[k];
+                    }
                 }
             }
         }
@@ -1104,7 +1542,6 @@ double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<i
     maxK = dot_prod(maxPoint(S, inspect_v), inspect_v);
 
     delete[] inspect_v;
-    delete[] v;
 
     if (VERBOSE)
         printf("LP max regret ratio = %lf\n", maxRegret);
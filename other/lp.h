@@ -19,6 +19,17 @@ point_t* find_feasible(std::vector<hyperplane_t*> hyperplane);
 // solve the LP in frame computation
 void solveLP(std::vector<point_t*> B, point_t* b, double& theta, point_t* & pi);
 
+/*
+ * The linear programs on the candidate utility range R = {u | u.v <= 0 for the extreme vectors v, u >= 0, sum(u) = 1},
+ * which use the extreme vectors only and not the extreme points of R
+ */
+// Use LP to find the minimum of c.u over R in value, and a utility vector where it is attained in u_min if not NULL;
+// returns false if R is empty
+bool utility_range_min(const std::vector<point_t*>& ext_vec, point_t* c, double& value, point_t* u_min);
+// Use LP to find the Chebyshev center of R within the hyperplane sum(u) = 1 (the center of the largest ball inside R);
+// returns the radius of the ball, 0 if R has no interior (the center is then any utility vector of R), and -1 if R is empty
+double utility_range_center(const std::vector<point_t*>& ext_vec, point_t* center);
+
 /*
  * The linear programs for computing MRR
  */
@@ -33,10 +44,37 @@ double determinant(int n, double** a);
  */
 // original MRR evaluation, consider worse case MRR
 double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE);
+// whether the MRR of S is at most eps, with the LPs of evaluateLP solved only for the points whose cheap upper bound
+// on the regret ratio exceeds eps, the largest bound first, until one of them exceeds eps
+// lp_count, when not null, receives the number of LPs solved
+bool mrr_at_most(point_set_t *p, point_set_t* S, double eps, int* lp_count = NULL);
 // use random sampling
 double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, int d, std::set<int> final_dimensions, int test_rounds = 20);
 // use the ground truth utility vector u
 double evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, point_t* u);
+// use the ground truth utility vector u, the largest utility of a point of the dataset for it being max_utility
+double evaluateLP(point_set_t* S, int VERBOSE, point_t* u, double max_utility);
+// use the ground truth utility vectors of U, one regret ratio for each, from one blocked pass over p and one over S
+std::vector<double> evaluateLP(point_set_t *p, point_set_t* S, int VERBOSE, point_set_t* U);
+// the largest utility of a point of p for each utility vector of U, in one blocked pass over p; the ground truth
+// evaluation divides by them, so they can be found once for the outputs of many trials
+std::vector<double> max_utilities(point_set_t* p, point_set_t* U);
+
+// the result of estimate_mrr
+struct mrr_estimate
+{
+	double mrr;		// the largest regret ratio of S over the utility vectors tried, at most the MRR
+	double mass;	// with confidence 1 - delta, the utility vectors on which S has a larger regret ratio have at most
+					// this probability under the sampling distribution
+	int samples;	// the samples of the distribution, without the perturbations
+};
+// estimate the MRR without LPs, from random utility vectors scored with batch_argmax, a batch at a time
+// the utility vectors are uniform on the simplex, or with d_prime > 0 have d_prime nonzero weights as the simulated
+// users of the experiments; the thread's random source (seed_thread_rand) draws them
+// every batch of samples also tries as many random perturbations of the worst utility vector found so far
+// the samples are doubled until doubling raises the estimate by at most tolerance, or max_samples are drawn
+mrr_estimate estimate_mrr(point_set_t *p, point_set_t* S, int VERBOSE, int d_prime = 0, double delta = 0.05,
+	double tolerance = 1e-3, int max_samples = 1 << 16);
 
 
 #endif
\ No newline at end of file
@@ -4,28 +4,37 @@
 // P: the input car set
 // C_idx: the indexes of the current candidate favorite car in P
 // ext_vec: the set of extreme vecotr
-int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec)
+// dom_option: the domination option; with HALFSPACE, the extreme points of R are not computed
+int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, int dom_option)
 {
 	int dim = P->points[0]->dim;
 
 	// the set of extreme points of the candidate utility range R
 	vector<point_t*> ext_pts;
-	ext_pts = get_extreme_pts(ext_vec);
-
-	// use the "mean" utility vector in R (other strategies could also be used)
 	point_t* mean = alloc_point(dim);
-	for(int i = 0; i < dim; i++)
-	{
-		mean->coord[i] = 0;
-	}
-	for(int i = 0; i < ext_pts.size(); i++)
+	if(dom_option == HALFSPACE)
 	{
-		for(int j = 0; j < dim; j++)
-			mean->coord[j] += ext_pts[i]->coord[j];
+		// use the center of R instead, or the center of all utility vectors if R is empty
+		if(utility_range_center(ext_vec, mean) < 0)
+		{
+			for(int i = 0; i < dim; i++)
+				mean->coord[i] = 1.0 / dim;
+		}
 	}
-	for(int i = 0; i < dim; i++)
+	else
 	{
-		mean->coord[i] /= ext_pts.size();
+		ext_pts = get_extreme_pts(ext_vec);
+
+		// use the "mean" utility vector in R (other strategies could also be used)
+		for(int i = 0; i < dim; i++)
+			mean->coord[i] = 0;
+		for(int i = 0; i < ext_pts.size(); i++)
+		{
+			for(int j = 0; j < dim; j++)
+				mean->coord[j] += ext_pts[i]->coord[j];
+		}
+		for(int i = 0; i < dim; i++)
+			mean->coord[i] /= ext_pts.size();
 	}
 
 	// look for the maximum utility point w.r.t. the "mean" utility vector
@@ -45,9 +54,53 @@ int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ex
 
 	for(int i = 0; i < ext_pts.size(); i++)
 		release_point(ext_pts[i]);
+	release_point(mean);
 	return best_pt_idx;
 }
 
+// the frame of the rays from the anchor car to the other cars of P, as indexes into P
+vector<int> compute_frame(point_set_t* P, int anchor)
+{
+	// the rays are dropped with the scope
+	point_arena_scope scope;
+
+	// create one ray for each car in P for computing the frame
+	vector<point_t*> rays;
+	rays.reserve(P->numberOfPoints);
+	for(int i = 0; i < P->numberOfPoints; i++)
+	{
+		if(i != anchor)
+			rays.push_back(sub(P->points[i], P->points[anchor]));
+	}
+
+	// frame compuatation
+	vector<int> frame;
+	frameConeFastLP(rays, frame);
+
+	// update the indexes lying after the anchor
+	for(int i = 0; i < frame.size(); i++)
+	{
+		if(frame[i] >= anchor)
+			frame[i]++;
+	}
+	return frame;
+}
+
+const vector<int>& frame_cache::frame(point_set_t* P, int anchor)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = frames.find(anchor);
+		if(it != frames.end())
+			return it->second;
+	}
+	// compute without the lock, so that the other runs keep using the cache meanwhile
+	vector<int> computed = compute_frame(P, anchor);
+	std::lock_guard<std::mutex> lock(mutex);
+	// a frame computed concurrently by another run is kept; both are the same
+	return frames.emplace(anchor, std::move(computed)).first->second;
+}
+
 // generate s cars for selection in a round
 // P: the input car set
 // C_idx: the indexes of the current candidate favorite car in P
@@ -56,7 +109,9 @@ int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ex
 // last_best: the best car in previous interaction
 // frame: the frame for obtaining the set of neibouring vertices of the current best vertiex (used only if cmp_option = SIMPLEX)
 // cmp_option: the car selection mode, which must be either SIMPLEX or RANDOM
-vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_best_idx, int& last_best, vector<int>& frame, int cmp_option)
+// generator: the random source of the RANDOM mode
+// frames: the frames of P computed so far (used only if cmp_option = SIMPLEX), or nullptr
+vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_best_idx, int& last_best, vector<int>& frame, int cmp_option, std::mt19937& generator, frame_cache* frames)
 {
 	// the set of s cars for selection
 	vector<int> S;
@@ -66,7 +121,7 @@ vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_be
 		// randoming select at most s non-overlaping cars in the candidate set 
 		while(S.size() < s && S.size() < C_idx.size())
 		{
-			int idx = rand() % C_idx.size();
+			int idx = std::uniform_int_distribution<int>(0, RAND_MAX)(generator) % C_idx.size();
 
 			bool isNew = true;
 			for(int i = 0; i < S.size(); i++)
@@ -85,36 +140,10 @@ vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_be
 	{
 		if(last_best != current_best_idx || frame.size() == 0) // the new frame is not computed before (avoid duplicate frame computation)
 		{
-			// create one ray for each car in P for computing the frame
-			vector<point_t*> rays;
-			int best_i = -1;
-			for(int i = 0; i < P->numberOfPoints; i++)
-			{
-				if(i == current_best_idx)
-				{
-					best_i = i;
-					continue;
-				}
-
-				point_t* best = P->points[current_best_idx];
-				point_t* newRay = sub(P->points[i], best);
-				rays.push_back(newRay);
-			}
-
-			// frame compuatation
-			frameConeFastLP(rays, frame);
-		
-			// update the indexes lying after current_best_idx
-			for(int i = 0; i < frame.size(); i++)
-			{
-				if(frame[i] >= current_best_idx)
-					frame[i]++;
-
-				//S[i] = C_idx[S[i]];
-			}
-
-			for(int i = 0; i < rays.size(); i++)
-				release_point(rays[i]);
+			if(frames != nullptr)
+				frame = frames->frame(P, current_best_idx);
+			else
+				frame = compute_frame(P, current_best_idx);
 		}
 
 		//printf("current_best: %d, frame:", P->points[current_best_idx]->id);
@@ -133,17 +162,16 @@ vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_be
 			}
 		}
 
+		// the positions in C_idx of the cars of P, -1 for the cars no longer in the candidate set
+		vector<int> position(P->numberOfPoints, -1);
+		for(int j = 0; j < C_idx.size(); j++)
+			position[C_idx[j]] = j;
+
 		// select at most s non-overlaping cars in the candidate set based on "neighboring vertices" obtained via frame compuation
 		for(int i = 0; i < frame.size() && S.size() < s; i++)
 		{
-			for(int j = 0; j < C_idx.size() && S.size() < s; j++)
-			{
-				if(C_idx[j] == current_best_idx)
-					continue;
-
-				if(C_idx[j] == frame[i])
-					S.push_back(j);
-			}
+			if(frame[i] != current_best_idx && position[frame[i]] != -1)
+				S.push_back(position[frame[i]]);
 		}
 
 		// if less than s car are selected, fill in the remaing one
@@ -217,7 +245,7 @@ vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_be
 void update_ext_vec(point_set_t* P, vector<int>& C_idx, point_t* u, int s, vector<point_t*>& ext_vec, int& current_best_idx, int& last_best, vector<int>& frame, int cmp_option)
 {
 	// generate s cars for selection in a round
-	vector<int> S = generate_S(P, C_idx, s, current_best_idx, last_best, frame, cmp_option);
+	vector<int> S = generate_S(P, C_idx, s, current_best_idx, last_best, frame, cmp_option, thread_rand_generator());
 
 	int max_i = -1;
 	double max = -1;
@@ -236,6 +264,14 @@ void update_ext_vec(point_set_t* P, vector<int>& C_idx, point_t* u, int s, vecto
 	}
 	//printf("\n");
 
+	apply_user_choice(P, C_idx, S, max_i, ext_vec, current_best_idx, last_best);
+}
+
+// update the extreme vecotrs and the candidate set with the car the user picked among S
+// S: the cars shown, as indexes into C_idx
+// max_i: the position of the picked car in S
+void apply_user_choice(point_set_t* P, vector<int>& C_idx, const vector<int>& S, int max_i, vector<point_t*>& ext_vec, int& current_best_idx, int& last_best)
+{
 	// get the better car among those from the user
 	last_best = current_best_idx;
 	current_best_idx = C_idx[S[max_i]];
@@ -278,7 +314,7 @@ void update_ext_vec(point_set_t* P, vector<int>& C_idx, point_t* u, int s, vecto
 // cmp_option: the car selection mode, which must be either SIMPLEX or RANDOM
 // stop_option: the stopping condition, which must be NO_BOUND or EXACT_BOUND or APRROX_BOUND
 // prune_option: the skyline algorithm, which must be either SQL or RTREE
-// dom_option: the domination checking mode, which must be either HYPER_PLANE or CONICAL_HULL
+// dom_option: the domination checking mode, which must be HYPER_PLANE, CONICAL_HULL or HALFSPACE
 point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int maxRound, double &Qcount, double &Csize,  int cmp_option, int stop_option, int prune_option, int dom_option)
 {
 	
@@ -313,7 +349,7 @@ point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int max
 
 	// get the index of the "current best" point
 	//if(cmp_option != RANDOM)
-	current_best_idx = get_current_best_pt(P, C_idx, ext_vec);
+	current_best_idx = get_current_best_pt(P, C_idx, ext_vec, dom_option);
 	
 	// if not skyline
 	//sql_pruning(P, C_idx, ext_vec);
@@ -323,9 +359,10 @@ point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int max
 
 	Qcount = 0;
 	double rr = 1;
+	conical_hull_cache conical;
 
 	// interactively reduce the candidate set and shrink the candidate utility range
-	while (C_idx.size()> 1 && (rr > epsilon  && !isZero(rr - epsilon)) && Qcount <  maxRound)  // while none of the stopping conditiong is true
+	while (C_idx.size()> 1 && (rr > epsilon  && !isZero(rr - epsilon)) && Qcount <  maxRound && !cancellation_requested())  // while none of the stopping conditiong is true
 	{
 		Qcount++;
 		sort(C_idx.begin(), C_idx.end()); // prevent select two different points after different skyline algorithms
@@ -338,13 +375,14 @@ point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int max
 
 		//update candidate set
 		if(prune_option == SQL)
-			sql_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option);
+			sql_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option, &conical);
 		else
-			rtree_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option);
+			rtree_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option, &conical);
 	}
+	release_conical_hull_cache(conical);
 
 	// get the final result 
-	point_t* result = P->points[get_current_best_pt(P, C_idx, ext_vec)];
+	point_t* result = P->points[get_current_best_pt(P, C_idx, ext_vec, dom_option)];
 	Csize = C_idx.size();
 
 	for (int i = 0; i < ext_vec.size(); i++)
@@ -353,20 +391,45 @@ point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int max
 	return result;
 }
 
+void question_mapping::record(const dimension_set& dimensions, const std::vector<int>& tuple_indices)
+{
+	auto found = positions.find(dimensions);
+	if (found != positions.end())
+		questions[found->second].second = tuple_indices;
+	else
+	{
+		positions[dimensions] = questions.size();
+		questions.push_back(std::make_pair(dimensions, tuple_indices));
+	}
+}
+
+std::vector<const std::pair<dimension_set, std::vector<int>>*> question_mapping::sorted() const
+{
+	std::vector<const std::pair<dimension_set, std::vector<int>>*> entries;
+	for (const auto& question : questions)
+		entries.push_back(&question);
+	std::sort(entries.begin(), entries.end(), [](const std::pair<dimension_set, std::vector<int>>* a, const std::pair<dimension_set, std::vector<int>>* b) {
+		return a->first < b->first;
+	});
+	return entries;
+}
+
 // construct extreme vectors from question mappings
-void construct_ext_vec_from_questions(point_set_t* P, const question_mapping& qm, point_t* u, vector<point_t*>& ext_vec, int full_dim, const std::map<int, int>& dim_mapping, point_set_t* D_prime)
+// key_dims: the reduced dimensions known to carry weight in the utility vector
+void construct_ext_vec_from_questions(point_set_t* P, const question_mapping& qm, const std::set<int>& key_dims, vector<point_t*>& ext_vec, int full_dim, const std::map<int, int>& dim_mapping, point_set_t* D_prime)
 {
-    for (const auto& question : qm.questions) {
-        const std::set<int>& original_dimensions = question.first;
-        const std::vector<int>& tuple_indices = question.second;
+    // visit the questions in the order of their dimensions, which fixes the order of the extreme vectors
+    for (const auto* question : qm.sorted()) {
+        const dimension_set& original_dimensions = question->first;
+        const std::vector<int>& tuple_indices = question->second;
         
-        // Check if the set contains more than one key dimension (non-zero weight in u)
+        // Check if the set contains more than one key dimension
         int key_dim_count = 0;
         for (int original_dim : original_dimensions) {
             // Map to reduced dimension and check if it's a key dimension
             if (dim_mapping.find(original_dim) != dim_mapping.end()) {
                 int reduced_dim = dim_mapping.at(original_dim);
-                if (reduced_dim < full_dim && u->coord[reduced_dim] > 0) {
+                if (reduced_dim < full_dim && key_dims.count(reduced_dim)) {
                     key_dim_count++;
                 }
             }
@@ -419,75 +482,127 @@ void construct_ext_vec_from_questions(point_set_t* P, const question_mapping& qm
     }
 }
 
-// the main interactive algorithm with pre-recorded questions
-point_t* max_utility_with_questions(point_set_t* P, point_t* u, int s, double epsilon, int maxRound, double &Qcount, double &Csize, int cmp_option, int stop_option, int prune_option, int dom_option, const question_mapping& qm, const std::map<int, int>& dim_mapping, point_set_t* D_prime)
+// start the interactive algorithm with the pre-recorded questions
+// P: the input dataset (assumed skyline)
+// state: the state to initialize
+// key_dims, dim_mapping, D_prime: see construct_ext_vec_from_questions
+// dom_option: the domination option of the pruning
+void max_utility_begin(point_set_t* P, max_utility_state& state, const question_mapping& qm, const std::set<int>& key_dims, const std::map<int, int>& dim_mapping, point_set_t* D_prime, int dom_option)
 {
-    int dim = P->points[0]->dim;
-
-    // the indexes of the candidate set
-    // initially, it is all the skyline cars
-    vector<int> C_idx;
-    for(int i = 0; i < P->numberOfPoints; i++)
-        C_idx.push_back(i);
-
-    double time;
-
-    // the initial exteme vector sets V = {−ei | i ∈ [1, d], ei [i] = 1 and ei [j] = 0 if i , j}.
-    vector<point_t*> ext_vec;
-    for (int i = 0; i < dim; i++)
-    {
-        point_t* e = alloc_point(dim);
-        for (int j = 0; j < dim; j++)
-        {
-            if (i == j)
-                e->coord[j] = -1;
-            else
-                e->coord[j] = 0;
-        }
-        ext_vec.push_back(e);
-    }
+	int dim = P->points[0]->dim;
 
-    // Construct extreme vectors from pre-recorded questions using dimension mapping
-    construct_ext_vec_from_questions(D_prime, qm, u, ext_vec, dim, dim_mapping, D_prime);
+	// the indexes of the candidate set
+	// initially, it is all the skyline cars
+	state.C_idx.clear();
+	for(int i = 0; i < P->numberOfPoints; i++)
+		state.C_idx.push_back(i);
 
-    int current_best_idx = -1;
-    int last_best = -1;
-    vector<int> frame;
+	// the initial exteme vector sets V = {−ei | i ∈ [1, d], ei [i] = 1 and ei [j] = 0 if i , j}.
+	state.ext_vec.clear();
+	for (int i = 0; i < dim; i++)
+	{
+		point_t* e = alloc_point(dim);
+		for (int j = 0; j < dim; j++)
+		{
+			if (i == j)
+				e->coord[j] = -1;
+			else
+				e->coord[j] = 0;
+		}
+		state.ext_vec.push_back(e);
+	}
 
-    // get the index of the "current best" point
-    current_best_idx = get_current_best_pt(P, C_idx, ext_vec);
-    
-    // Qcount - the number of querstions asked
-    // Csize - the size of the current candidate set
+	// Construct extreme vectors from pre-recorded questions using dimension mapping
+	construct_ext_vec_from_questions(D_prime, qm, key_dims, state.ext_vec, dim, dim_mapping, D_prime);
 
-    Qcount = 0;
-    double rr = 1;
+	state.last_best = -1;
+	state.frame.clear();
+	state.S.clear();
 
-    // interactively reduce the candidate set and shrink the candidate utility range
-    while (C_idx.size()> 1 && (rr > epsilon  && !isZero(rr - epsilon)) && Qcount <  maxRound)  // while none of the stopping conditiong is true
-    {
-        Qcount++;
-        sort(C_idx.begin(), C_idx.end()); // prevent select two different points after different skyline algorithms
-        
-        // generate the options for user selection and update the extreme vecotrs based on the user feedback
-        update_ext_vec(P, C_idx, u, s, ext_vec, current_best_idx, last_best, frame, cmp_option);
+	// get the index of the "current best" point
+	state.current_best_idx = get_current_best_pt(P, state.C_idx, state.ext_vec, dom_option);
+
+	state.rounds = 0;
+	state.rr = 1;
+}
 
-        if(C_idx.size()==1 ) // || global_best_idx == current_best_idx
-            break;
+// generate the cars of the next question in state.S
+// returns false if one of the stopping conditions holds
+bool max_utility_next(point_set_t* P, max_utility_state& state, int s, double epsilon, int maxRound, int cmp_option, std::mt19937& generator, frame_cache* frames)
+{
+	if (!(state.C_idx.size() > 1 && (state.rr > epsilon && !isZero(state.rr - epsilon)) && state.rounds < maxRound && !cancellation_requested()))
+		return false;
 
-        //update candidate set
-        if(prune_option == SQL)
-            sql_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option);
-        else
-            rtree_pruning(P, C_idx, ext_vec, rr, stop_option, dom_option);
-    }
+	state.rounds++;
+	sort(state.C_idx.begin(), state.C_idx.end()); // prevent select two different points after different skyline algorithms
+	state.S = generate_S(P, state.C_idx, s, state.current_best_idx, state.last_best, state.frame, cmp_option, generator, frames);
+	return true;
+}
+
+// update the extreme vecotrs and the candidate set with the answer to the question of max_utility_next
+// choice: the position in state.S of the car the user picked
+void max_utility_submit(point_set_t* P, max_utility_state& state, int choice, int stop_option, int prune_option, int dom_option)
+{
+	apply_user_choice(P, state.C_idx, state.S, choice, state.ext_vec, state.current_best_idx, state.last_best);
+	state.S.clear();
+
+	if(state.C_idx.size() == 1)
+		return;
+
+	//update candidate set
+	if(prune_option == SQL)
+		sql_pruning(P, state.C_idx, state.ext_vec, state.rr, stop_option, dom_option, &state.conical);
+	else
+		rtree_pruning(P, state.C_idx, state.ext_vec, state.rr, stop_option, dom_option, &state.conical);
+}
+
+// get the final result and release the extreme vectors
+point_t* max_utility_finish(point_set_t* P, max_utility_state& state, double &Csize, int dom_option)
+{
+	point_t* result = P->points[get_current_best_pt(P, state.C_idx, state.ext_vec, dom_option)];
+	Csize = state.C_idx.size();
+
+	for (int i = 0; i < state.ext_vec.size(); i++)
+		release_point(state.ext_vec[i]);
+	state.ext_vec.clear();
+	release_conical_hull_cache(state.conical);
 
-    // get the final result 
-    point_t* result = P->points[get_current_best_pt(P, C_idx, ext_vec)];
-    Csize = C_idx.size();
+	return result;
+}
 
-    for (int i = 0; i < ext_vec.size(); i++)
-        release_point(ext_vec[i]);
+// the main interactive algorithm with pre-recorded questions, answered with the utility vector u
+point_t* max_utility_with_questions(point_set_t* P, point_t* u, int s, double epsilon, int maxRound, double &Qcount, double &Csize, int cmp_option, int stop_option, int prune_option, int dom_option, const question_mapping& qm, const std::map<int, int>& dim_mapping, point_set_t* D_prime)
+{
+	int dim = P->points[0]->dim;
+
+	// the dimensions with weight in u
+	std::set<int> key_dims;
+	for (int i = 0; i < dim; i++)
+	{
+		if (u->coord[i] > 0)
+			key_dims.insert(i);
+	}
+
+	max_utility_state state;
+	max_utility_begin(P, state, qm, key_dims, dim_mapping, D_prime, dom_option);
+
+	// interactively reduce the candidate set and shrink the candidate utility range
+	while (max_utility_next(P, state, s, epsilon, maxRound, cmp_option, thread_rand_generator()))
+	{
+		int max_i = -1;
+		double max = -1;
+		for(int i = 0; i < state.S.size(); i++)
+		{
+			double v = dot_prod(u, P->points[ state.C_idx[state.S[i]] ]);
+			if(v > max)
+			{
+				max = v;
+				max_i = i;
+			}
+		}
+		max_utility_submit(P, state, max_i, stop_option, prune_option, dom_option);
+	}
 
-    return result;
+	Qcount = state.rounds;
+	return max_utility_finish(P, state, Csize, dom_option);
 }
@@ -12,7 +12,13 @@
 #include "rtree.h"
 #include "lp.h"
 #include "pruning.h"
+#include "cancellation.h"
+#include "dimension_set.h"
+#include <mutex>
 #include <queue>
+#include <random>
+#include <set>
+#include <unordered_map>
 
 #define RANDOM 1
 #define SIMPLEX 2
@@ -22,26 +28,72 @@ using namespace std;
 
 // Data structure to store question mappings
 // Maps set of dimensions to vector of presented tuple indices (first one is user's choice)
+// the entries are kept in recording order and found by the hash of their dimensions
 struct question_mapping {
-    std::map<std::set<int>, std::vector<int>> questions;
+    std::vector<std::pair<dimension_set, std::vector<int>>> questions;
+    std::unordered_map<dimension_set, int, dimension_set_hash> positions;	// of the entries in questions
+
+    // a later question on the same dimensions replaces the earlier one
+    void record(const dimension_set& dimensions, const std::vector<int>& tuple_indices);
+    // the entries in the order of their dimensions
+    std::vector<const std::pair<dimension_set, std::vector<int>>*> sorted() const;
+};
+
+// the frames of the SIMPLEX car selection of one point set, by anchor car
+// the frame of an anchor depends on the point set only, so the runs on the same point set share it;
+// frame may be called from several threads
+class frame_cache {
+public:
+	// the indexes of the cars of P whose rays from the anchor car span the cone of the rays to all cars of P
+	const vector<int>& frame(point_set_t* P, int anchor);
+
+private:
+	std::mutex mutex;
+	std::unordered_map<int, vector<int>> frames;	// never erased, so the returned frames stay valid
+};
+
+// the state of the interactive algorithm between two questions
+struct max_utility_state {
+	vector<int> C_idx;			// the indexes of the candidate set
+	vector<point_t*> ext_vec;	// the extreme vectors of the candidate utility range
+	int current_best_idx;
+	int last_best;
+	vector<int> frame;			// used only if cmp_option = SIMPLEX
+	double rr;					// the regret ratio bound of the last pruning
+	int rounds;					// the number of questions asked
+	vector<int> S;				// the cars of the pending question, as indexes into C_idx
+	conical_hull_cache conical;	// used only if dom_option = CONICAL_HULL
 };
 
 // get the index of the "current best" point
-int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec);
+int get_current_best_pt(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, int dom_option);
 
 // generate s cars for selection in a round
 void update_ext_vec(point_set_t* P, vector<int>& C_idx, point_t* u, int s, vector<point_t*>& ext_vec, int& current_best_idx, int& last_best, vector<int>& frame, int cmp_option);
 
 // generate the options for user selection and update the extreme vecotrs based on the user feedback
-vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_best_idx, int& last_best, vector<int>& frame, int cmp_option);
+// with frames, the SIMPLEX frame of current_best_idx is taken from and kept in frames
+vector<int> generate_S(point_set_t* P, vector<int>& C_idx, int s, int current_best_idx, int& last_best, vector<int>& frame, int cmp_option, std::mt19937& generator, frame_cache* frames = nullptr);
+
+// update the extreme vecotrs and the candidate set with the car the user picked among S
+void apply_user_choice(point_set_t* P, vector<int>& C_idx, const vector<int>& S, int max_i, vector<point_t*>& ext_vec, int& current_best_idx, int& last_best);
 
 // the main interactive algorithm
 point_t* max_utility(point_set_t* P, point_t* u, int s,  double epsilon, int maxRound, double &Qcount, double &Csize,  int cmp_option, int stop_option, int prune_option, int dom_option);
 
-// the main interactive algorithm with pre-recorded questions
+// the interactive algorithm with pre-recorded questions, one question at a time:
+// max_utility_begin once, then max_utility_next for each question and max_utility_submit with its answer, until
+// max_utility_next returns false; max_utility_finish returns the result
+// frames, if any, must belong to P
+void max_utility_begin(point_set_t* P, max_utility_state& state, const question_mapping& qm, const std::set<int>& key_dims, const std::map<int, int>& dim_mapping, point_set_t* D_prime, int dom_option);
+bool max_utility_next(point_set_t* P, max_utility_state& state, int s, double epsilon, int maxRound, int cmp_option, std::mt19937& generator, frame_cache* frames = nullptr);
+void max_utility_submit(point_set_t* P, max_utility_state& state, int choice, int stop_option, int prune_option, int dom_option);
+point_t* max_utility_finish(point_set_t* P, max_utility_state& state, double &Csize, int dom_option);
+
+// the main interactive algorithm with pre-recorded questions, answered with the utility vector u
 point_t* max_utility_with_questions(point_set_t* P, point_t* u, int s, double epsilon, int maxRound, double &Qcount, double &Csize, int cmp_option, int stop_option, int prune_option, int dom_option, const question_mapping& qm, const std::map<int, int>& dim_mapping, point_set_t* D_prime);
 
 // construct extreme vectors from question mappings
-void construct_ext_vec_from_questions(point_set_t* P, const question_mapping& qm, point_t* u, vector<point_t*>& ext_vec, int full_dim, const std::map<int, int>& dim_mapping, point_set_t* D_prime);
+void construct_ext_vec_from_questions(point_set_t* P, const question_mapping& qm, const std::set<int>& key_dims, vector<point_t*>& ext_vec, int full_dim, const std::map<int, int>& dim_mapping, point_set_t* D_prime);
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "medianhull.h"
+#include "metrics.h"
 
 #ifdef WIN32
 #ifdef __cplusplus 
@@ -129,6 +130,8 @@ vector<point_t*> getVertices(point_set_t* P)
 		qh_init_B(points, count, dim, ismalloc);
 		qh_qhull();
 		qh_check_output();
+		metric_add(METRIC_QHULL_CALLS);
+		metric_add(METRIC_QHULL_VERTICES, qh num_vertices);
 
 		//printf ("\n%d vertices and %d facets with normals:\n",
         //         qh num_vertices, qh num_facets);
@@ -0,0 +1,60 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+#ifndef NO_METRICS
+thread_local metrics_state thread_metrics = {};
+#endif
+
+namespace {
+
+const char* counter_names[METRIC_COUNTER_COUNT] = {
+	"lp_worst_direction", "lp_find_feasible", "lp_solve", "lp_inside_cone", "lp_utility_range",
+	"qhull_calls", "qhull_vertices",
+	"skyline_calls", "skyline_input_points", "skyline_output_points",
+	"projections", "projected_points", "rtree_builds",
+};
+
+const char* timer_names[METRIC_TIMER_COUNT] = {
+	"phase_1_seconds", "phase_2_seconds", "phase_3_prepare_seconds", "phase_3_seconds",
+};
+
+} // namespace
+
+void reset_metrics()
+{
+#ifndef NO_METRICS
+	thread_metrics = metrics_state();
+#endif
+}
+
+metrics_state snapshot_metrics()
+{
+#ifndef NO_METRICS
+	return thread_metrics;
+#else
+	return metrics_state();
+#endif
+}
+
+std::string format_metrics(const metrics_state& metrics)
+{
+#ifndef NO_METRICS
+	std::string out = "{";
+	char buffer[64];
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+	{
+		snprintf(buffer, sizeof(buffer), "%s\"%s\":%lld", i > 0 ? "," : "", counter_names[i], metrics.counters[i]);
+		out += buffer;
+	}
+	for (int i = 0; i < METRIC_TIMER_COUNT; i++)
+	{
+		snprintf(buffer, sizeof(buffer), ",\"%s\":%.9g", timer_names[i], metrics.timers[i]);
+		out += buffer;
+	}
+	return out + "}";
+#else
+	(void)metrics;
+	return "";
+#endif
+}
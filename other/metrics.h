@@ -0,0 +1,92 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <string>
+
+// counters and phase timers of the hot paths on the current thread, reported with the experiment records
+// building with -DNO_METRICS compiles every counter and timer away
+
+enum metric_counter {
+	METRIC_LP_WORST_DIRECTION,	// worstDirection LPs
+	METRIC_LP_FIND_FEASIBLE,	// find_feasible LPs
+	METRIC_LP_SOLVE,			// solveLP LPs
+	METRIC_LP_INSIDE_CONE,		// insideCone LPs
+	METRIC_LP_UTILITY_RANGE,	// utility_range_min and utility_range_center LPs
+	METRIC_QHULL_CALLS,			// qhull invocations
+	METRIC_QHULL_VERTICES,		// vertices of all computed hulls
+	METRIC_SKYLINE_CALLS,		// skyline_point calls
+	METRIC_SKYLINE_INPUT,		// points passed to skyline_point
+	METRIC_SKYLINE_OUTPUT,		// skyline points returned by skyline_point
+	METRIC_PROJECTIONS,			// datasets projected onto a subset of the dimensions
+	METRIC_PROJECTED_POINTS,	// points of the projected datasets
+	METRIC_RTREE_BUILDS,		// R-trees constructed
+	METRIC_COUNTER_COUNT
+};
+
+enum metric_timer {
+	METRIC_TIME_PHASE_1,		// dimension block questions
+	METRIC_TIME_PHASE_2,		// binary splitting questions
+	METRIC_TIME_PHASE_3_PREPARE,	// projection and skyline of the candidate dimensions
+	METRIC_TIME_PHASE_3,		// interactive search or attribute subset
+	METRIC_TIMER_COUNT
+};
+
+struct metrics_state {
+	long long counters[METRIC_COUNTER_COUNT];
+	double timers[METRIC_TIMER_COUNT];
+};
+
+#ifndef NO_METRICS
+
+extern thread_local metrics_state thread_metrics;
+
+inline void metric_add(metric_counter counter, long long amount = 1)
+{
+	thread_metrics.counters[counter] += amount;
+}
+
+inline void metric_add_time(metric_timer timer, double seconds)
+{
+	thread_metrics.timers[timer] += seconds;
+}
+
+// adds the wall time since construction, or since the previous lap, to a timer
+class metric_stopwatch {
+public:
+	metric_stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+	void lap(metric_timer timer)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		thread_metrics.timers[timer] += std::chrono::duration<double>(now - start_).count();
+		start_ = now;
+	}
+
+private:
+	std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+inline void metric_add(metric_counter, long long = 1) {}
+
+inline void metric_add_time(metric_timer, double) {}
+
+class metric_stopwatch {
+public:
+	void lap(metric_timer) {}
+};
+
+#endif
+
+// clear the metrics of the current thread
+void reset_metrics();
+
+// the metrics of the current thread
+metrics_state snapshot_metrics();
+
+// the metrics as a JSON object, or an empty string when metrics are compiled out
+std::string format_metrics(const metrics_state& metrics);
+
+#endif
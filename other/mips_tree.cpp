@@ -0,0 +1,209 @@
+#include "mips_tree.h"
+#include "operation.h"
+
+#include <algorithm>
+
+namespace {
+
+// the most points of a leaf
+const int LEAF_SIZE = 32;
+
+// the relative error allowed in the bound of a ball, for the rounding of its inner products
+const double BOUND_SLACK = 1e-9;
+const double ANGLE_SLACK = 1e-10;
+
+double distance(point_t* p, const double* c)
+{
+	double sum = 0;
+	for (int i = 0; i < p->dim; i++)
+	{
+		double diff = p->coord[i] - c[i];
+		sum += diff * diff;
+	}
+	return sqrt(sum);
+}
+
+} // namespace
+
+mips_tree::mips_tree(point_set_t* p) : p_(p), dim_(p->points[0]->dim)
+{
+	order_.resize(p->numberOfPoints);
+	for (int i = 0; i < p->numberOfPoints; i++)
+		order_[i] = i;
+	build(0, p->numberOfPoints);
+
+	coords_.resize((size_t)p->numberOfPoints * dim_);
+	for (int i = 0; i < p->numberOfPoints; i++)
+		for (int j = 0; j < dim_; j++)
+			coords_[(size_t)i * dim_ + j] = p->points[order_[i]]->coord[j];
+}
+
+int mips_tree::build(int begin, int end)
+{
+	int index = nodes_.size();
+	nodes_.push_back(node());
+	centers_.resize(centers_.size() + dim_, 0);
+
+	// the center is the mean of the points, the radius their largest distance to it
+	double* c = &centers_[index * dim_];
+	for (int i = begin; i < end; i++)
+	{
+		point_t* pt = p_->points[order_[i]];
+		for (int j = 0; j < dim_; j++)
+			c[j] += pt->coord[j];
+	}
+	for (int j = 0; j < dim_; j++)
+		c[j] /= end - begin;
+
+	double radius = 0;
+	int far = begin;
+	for (int i = begin; i < end; i++)
+	{
+		double d = distance(p_->points[order_[i]], c);
+		if (d > radius)
+		{
+			radius = d;
+			far = i;
+		}
+	}
+	nodes_[index].begin = begin;
+	nodes_[index].end = end;
+	nodes_[index].left = -1;
+	nodes_[index].right = -1;
+	nodes_[index].radius = radius;
+	nodes_[index].center_len = sqrt(dot_prod(c, c, dim_));
+
+	// the cone around the direction of the center that holds the points, and their largest length
+	double max_len = 0, min_cos = 1;
+	for (int i = begin; i < end; i++)
+	{
+		point_t* pt = p_->points[order_[i]];
+		double len = calc_len(pt);
+		if (len > max_len)
+			max_len = len;
+		if (len > 0 && nodes_[index].center_len > 0)
+			min_cos = std::min(min_cos, dot_prod(pt, c) / (len * nodes_[index].center_len));
+	}
+	nodes_[index].max_len = max_len;
+	// widened for the rounding of the angles, which the square roots in bound magnify near 0
+	nodes_[index].cos_angle = nodes_[index].center_len > 0 ? std::max(-1.0, min_cos - ANGLE_SLACK) : -1;
+
+	if (end - begin <= LEAF_SIZE || radius == 0)
+		return index;
+
+	// split at the median of the projections on the line through the point farthest from the center and the point
+	// farthest from that one
+	point_t* a = p_->points[order_[far]];
+	point_t* b = a;
+	double spread = 0;
+	for (int i = begin; i < end; i++)
+	{
+		double d = calc_dist(a, p_->points[order_[i]]);
+		if (d > spread)
+		{
+			spread = d;
+			b = p_->points[order_[i]];
+		}
+	}
+	std::vector<double> direction(dim_);
+	for (int j = 0; j < dim_; j++)
+		direction[j] = b->coord[j] - a->coord[j];
+
+	std::vector<std::pair<double, int>> projections(end - begin);
+	for (int i = begin; i < end; i++)
+		projections[i - begin] = std::make_pair(dot_prod(p_->points[order_[i]], &direction[0]), order_[i]);
+	int middle = (end - begin) / 2;
+	std::nth_element(projections.begin(), projections.begin() + middle, projections.end());
+	for (int i = begin; i < end; i++)
+		order_[i] = projections[i - begin].second;
+
+	int left = build(begin, begin + middle);
+	int right = build(begin + middle, end);
+	nodes_[index].left = left;
+	nodes_[index].right = right;
+	return index;
+}
+
+double mips_tree::bound(int index, double* v, double v_len) const
+{
+	const node& n = nodes_[index];
+	const double* c = &centers_[index * dim_];
+	double cv = 0;
+	for (int j = 0; j < dim_; j++)
+		cv += c[j] * v[j];
+	double bound = cv + n.radius * v_len;
+
+	// the points are within the angle of the cone from the center, so v is at least the rest of its angle away
+	if (n.center_len > 0 && v_len > 0)
+	{
+		double cos_v = std::max(-1.0, std::min(1.0, cv / (n.center_len * v_len)));
+		double cone_bound = n.max_len * v_len;
+		if (cos_v < n.cos_angle)
+		{
+			// cos(theta - alpha) with cos(theta) = cos_v and cos(alpha) = cos_angle
+			double sin_v = sqrt(1 - cos_v * cos_v), sin_angle = sqrt(1 - n.cos_angle * n.cos_angle);
+			cone_bound *= cos_v * n.cos_angle + sin_v * sin_angle;
+		}
+		bound = std::min(bound, cone_bound);
+	}
+	return bound + BOUND_SLACK * v_len * (n.center_len + n.radius + n.max_len);
+}
+
+void mips_tree::search(int index, double* v, double v_len, int& best, double& best_value) const
+{
+	const node& n = nodes_[index];
+	if (n.left < 0)
+	{
+		// as the scan of maxPoint, which keeps the first of equal points
+		double slack = BOUND_SLACK * v_len * n.max_len;
+		for (int i = n.begin; i < n.end; i++)
+		{
+			const COORD_TYPE* x = &coords_[(size_t)i * dim_];
+			double value = 0;
+			for (int j = 0; j < dim_; j++)
+				value += x[j] * v[j];
+			if (value < best_value - slack)
+				continue;
+
+			// decided on the inner product of maxPoint, which may round differently
+			int idx = order_[i];
+			value = dot_prod(p_->points[idx], v);
+			if (value > best_value || (value == best_value && value > 0 && idx < best))
+			{
+				best = idx;
+				best_value = value;
+			}
+		}
+		return;
+	}
+
+	// the child with the larger bound first, which makes the other one more likely to be skipped
+	double left_bound = bound(n.left, v, v_len);
+	double right_bound = bound(n.right, v, v_len);
+	int first = n.left, second = n.right;
+	double second_bound = right_bound;
+	if (right_bound > left_bound)
+	{
+		std::swap(first, second);
+		second_bound = left_bound;
+	}
+	// a ball whose bound equals the best may hold an equal point that comes first in p
+	if (std::max(left_bound, right_bound) >= best_value)
+		search(first, v, v_len, best, best_value);
+	if (second_bound >= best_value)
+		search(second, v, v_len, best, best_value);
+}
+
+point_t* mips_tree::max_point(double* v) const
+{
+	return p_->points[max_index(v)];
+}
+
+int mips_tree::max_index(double* v) const
+{
+	int best = 0;
+	double best_value = 0;
+	double v_len = sqrt(dot_prod(v, v, dim_));
+	search(0, v, v_len, best, best_value);
+	return best;
+}
@@ -0,0 +1,47 @@
+#ifndef MIPS_TREE_H
+#define MIPS_TREE_H
+
+#include "data_struct.h"
+
+#include <vector>
+
+// an exact maximum inner product index of a point set, built once and queried for many directions
+// a ball tree: the inner product of v with the points in a ball of center c and radius r is at most v.c + r|v|, and
+// at most |v| times their largest length if v is within the cone around c that holds them, and less as v leaves it;
+// the balls whose bound is below the best point so far are skipped
+// the tree keeps a copy of the coordinates in its own order, so that a ball is scanned from contiguous memory
+// max_point(v) returns the point that the linear scan maxPoint(p, v) returns, ties included
+// the points of p must not change while the tree is used; queries may run on several threads
+class mips_tree {
+public:
+	explicit mips_tree(point_set_t* p);
+
+	// the first point of p with the largest positive inner product with v, or the first point if there is none
+	point_t* max_point(double* v) const;
+	// the index in p of max_point(v)
+	int max_index(double* v) const;
+
+private:
+	struct node {
+		int begin, end;		// the points order_[begin..end)
+		int left, right;	// the children, -1 in a leaf
+		double radius;
+		double center_len;
+		double max_len;		// of the points
+		double cos_angle;	// of the cone around the center that holds the points
+	};
+
+	int build(int begin, int end);
+	void search(int index, double* v, double v_len, int& best, double& best_value) const;
+	// the upper bound of the inner product of v with the points of a node
+	double bound(int index, double* v, double v_len) const;
+
+	point_set_t* p_;
+	int dim_;
+	std::vector<int> order_;		// the indexes of the points of p, each node covers a range
+	std::vector<node> nodes_;
+	std::vector<double> centers_;		// dim_ coordinates per node
+	std::vector<COORD_TYPE> coords_;	// the points in the order of order_
+};
+
+#endif
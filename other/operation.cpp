@@ -1,5 +1,6 @@
 #include "operation.h"
 #include "data_utility.h"
+#include "metrics.h"
 #include <stdlib.h>
 #include <chrono>
 #include <random>
@@ -16,6 +17,7 @@ vector<vector<double> > generate_JL(int k, int d, int matrix_type);
 vector<vector<double> > generate_JL(int k, int d, point_set_t* &P);
 point_set_t* dim_reduce(point_set_t* &point_set, vector<vector<double> > JL);
 int isZero(double x);
+int isCoordZero(double x);
 DIST_TYPE calc_len(point_t* point_v);
 point_t* copy(point_t* point_v2);
 double dot_prod(point_t* point_v1, point_t* point_v2);
@@ -33,6 +35,7 @@ vector<double> gaussNtimesD(vector<vector<double> > A);
 point_t* projectPointsOntoAffineSpace(point_set_t* space, point_t* p);
 Vvi build_input(int t, int dim);
 void cart_product(Vvi& rvvi, Vi& rvi, Vvi::const_iterator me, Vvi::const_iterator end);
+point_set_t* try_read_points(const char* input);
 point_set_t* read_points(char* input);
 int dominates(point_t* p1, point_t* p2);
 point_set_t* skyline_point(point_set_t *p);
@@ -167,6 +170,11 @@ int isZero(double x) {
     return x > -EQN_EPS && x < EQN_EPS;
 }
 
+// zero up to the precision of stored coordinates
+int isCoordZero(double x) {
+    return x > -COORD_EPS && x < COORD_EPS;
+}
+
 DIST_TYPE calc_len(point_t* point_v) {
     int dim = point_v->dim;
     DIST_TYPE diff = 0;
@@ -246,6 +254,16 @@ float rand_f(float min_v, float max_v) {
     return (max_v - min_v) * rand_v + min_v;
 }
 
+// Per-thread random source
+std::mt19937& thread_rand_generator() {
+    thread_local std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
+void seed_thread_rand(unsigned int seed) {
+    thread_rand_generator().seed(seed);
+}
+
 DIST_TYPE calc_dist(point_t* point_v1, point_t* point_v2) {
     int dim = point_v1->dim;
     DIST_TYPE diff = 0;
@@ -257,14 +275,14 @@ DIST_TYPE calc_dist(point_t* point_v1, point_t* point_v2) {
 }
 
 bool isViolated(point_t* normal_q, point_t* normal_p, point_t* e) {
-    if (isZero(calc_dist(normal_q, normal_p))) {
+    if (isCoordZero(calc_dist(normal_q, normal_p))) {
         return true;
     }
 
     point_t* temp_normal = sub(normal_q, normal_p);
     point_t* temp = sub(e, normal_p);
     
-    bool result = (dot_prod(temp_normal, temp) > 0 && !isZero(dot_prod(temp_normal, temp)));
+    bool result = (dot_prod(temp_normal, temp) > 0 && !isCoordZero(dot_prod(temp_normal, temp)));
     
     release_point(temp_normal);
     release_point(temp);
@@ -372,7 +390,7 @@ vector<double> gaussNtimesD(vector<vector<double>> A) {
     for (int i = 0; i < n; i++) {
         bool allZero = true;
         for (int j = 0; j < d + 1; j++) {
-            if (!isZero(A[i][j])) {
+            if (!isCoordZero(A[i][j])) {
                 allZero = false;
                 break;
             }
@@ -487,34 +505,51 @@ void cart_product(Vvi& rvvi, Vi& rvi, Vvi::const_iterator me, Vvi::const_iterato
     }
 }
 
-// Read points from file
-point_set_t* read_points(char* input) {
-    FILE* c_fp;
-    char filename[MAX_FILENAME_LENG];
-    sprintf(filename, "%s", input);
-
-    if ((c_fp = fopen(filename, "r")) == NULL) {
-        fprintf(stderr, "Cannot open the data file %s.\n", filename);
-        exit(0);
-    }
+// Read points from file; NULL if it cannot be opened or does not hold the point count, the dimension and
+// every coordinate
+point_set_t* try_read_points(const char* input) {
+    FILE* c_fp = fopen(input, "r");
+    if (c_fp == NULL)
+        return NULL;
 
     int number_of_points, dim;
-    fscanf(c_fp, "%i%i", &number_of_points, &dim);
+    if (fscanf(c_fp, "%i%i", &number_of_points, &dim) != 2 || number_of_points < 0 || dim < 1) {
+        fclose(c_fp);
+        return NULL;
+    }
 
     point_set_t* point_set = alloc_point_set(number_of_points);
 
     for (int i = 0; i < number_of_points; i++) {
         point_t* p = alloc_point(dim, i);
+        point_set->points[i] = p;
         for (int j = 0; j < dim; j++) {
-            fscanf(c_fp, "%lf", &p->coord[j]);
+            double value;
+            if (fscanf(c_fp, "%lf", &value) != 1) {
+                // the points after i were never allocated
+                point_set->numberOfPoints = i + 1;
+                release_point_set(point_set, true);
+                fclose(c_fp);
+                return NULL;
+            }
+            p->coord[j] = value;
         }
-        point_set->points[i] = p;
     }
 
     fclose(c_fp);
     return point_set;
 }
 
+// Read points from file, and exit if it cannot be read
+point_set_t* read_points(char* input) {
+    point_set_t* point_set = try_read_points(input);
+    if (point_set == NULL) {
+        fprintf(stderr, "Cannot read the data file %s.\n", input);
+        exit(0);
+    }
+    return point_set;
+}
+
 // Check dominance for skyline computation
 int dominates(point_t* p1, point_t* p2) {
     for (int i = 0; i < p1->dim; ++i)
@@ -553,6 +588,9 @@ point_set_t* skyline_point(point_set_t* p) {
     for (int i = 0; i < index; i++)
         skyline->points[i] = p->points[sl[i]];
 
+    metric_add(METRIC_SKYLINE_CALLS);
+    metric_add(METRIC_SKYLINE_INPUT, p->numberOfPoints);
+    metric_add(METRIC_SKYLINE_OUTPUT, index);
     delete[] sl;
     return skyline;
 }
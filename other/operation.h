@@ -4,6 +4,7 @@
 #include "data_struct.h"
 #include <vector>
 #include <cstdio>
+#include <random>
 
 using namespace std;
 
@@ -14,12 +15,19 @@ typedef vector<Vi> Vvi;
 // Constants
 #define MAX_FILENAME_LENG 256
 #define EQN_EPS 1e-9
+// tolerance of geometric tests on stored coordinates, which carry only single precision with COORD_FLOAT
+#ifdef COORD_FLOAT
+#define COORD_EPS 1e-6
+#else
+#define COORD_EPS EQN_EPS
+#endif
 
 // Common functions
 point_set_t* remove_outliers(point_set_t* &point_set);
 void linear_normalize(point_set_t* &point_set);
 void reduce_to_unit(point_set_t* &point_set);
 int isZero(double x);
+int isCoordZero(double x);
 DIST_TYPE calc_len(point_t* point_v);
 point_t* copy(point_t* point_v2);
 
@@ -33,6 +41,9 @@ point_t* scale(double c, point_t* point_v);
 
 // Functions from sphere/operation.cpp
 float rand_f(float min_v, float max_v);
+// per-thread replacement of srand()/rand(), used where concurrent trials must stay reproducible
+std::mt19937& thread_rand_generator();
+void seed_thread_rand(unsigned int seed);
 DIST_TYPE calc_dist(point_t* point_v1, point_t* point_v2);
 bool isViolated(point_t* normal_q, point_t* normal_p, point_t* e);
 point_t* maxPoint(point_set_t* p, double *v);
@@ -41,6 +52,7 @@ vector<double> gaussNtimesD(vector<vector<double>> A);
 point_t* projectPointsOntoAffineSpace(point_set_t* space, point_t* p);
 Vvi build_input(int t, int dim);
 void cart_product(Vvi& rvvi, Vi& rvi, Vvi::const_iterator me, Vvi::const_iterator end);
+point_set_t* try_read_points(const char* input);
 point_set_t* read_points(char* input);
 int dominates(point_t* p1, point_t* p2);
 point_set_t* skyline_point(point_set_t *p);
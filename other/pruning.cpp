@@ -1,7 +1,24 @@
 #include "pruning.h"
+#include "metrics.h"
+
+#include <atomic>
 
 char hidden_options[]=" d n v Qbb QbB Qf Qg Qm Qr QR Qv Qx Qz TR E V Fa FA FC FD FS Ft FV Gt Q0 Q1 Q2 Q3 Q4 Q5 Q6 Q7 Q8 Q9 ";
 
+std::mutex qhull_mutex;
+
+// suffix of the scratch files used for the half space intersection
+// the first thread keeps the plain file names, every other thread gets its own files
+const char* scratch_file_suffix()
+{
+	static std::atomic<int> next_thread(0);
+	thread_local int thread_index = next_thread++;
+	thread_local char suffix[32] = "";
+	if (thread_index > 0 && suffix[0] == '\0')
+		sprintf(suffix, "_%d", thread_index);
+	return suffix;
+}
+
 #ifdef WIN32
 #ifdef __cplusplus 
 	extern "C" { 
@@ -90,6 +107,8 @@ int halfspace(FILE* rPtr, FILE* wPtr) {
 		qh_init_B(points, numpoints, dim, ismalloc);
 		qh_qhull();
 		qh_check_output();
+		metric_add(METRIC_QHULL_CALLS);
+		metric_add(METRIC_QHULL_VERTICES, qh num_vertices);
 		qh_produce_output();
 		//print_summary();
 
@@ -116,9 +135,9 @@ vector<point_t*> get_extreme_pts(vector<point_t*>& ext_vec)
 {
 	int dim = ext_vec[0]->dim;
 	char file1[MAX_FILENAME_LENG];
-	sprintf(file1, "output/hyperplane_data");
+	sprintf(file1, "output/hyperplane_data%s", scratch_file_suffix());
 	char file2[MAX_FILENAME_LENG];
-	sprintf(file2, "output/ext_pt");
+	sprintf(file2, "output/ext_pt%s", scratch_file_suffix());
 
 	// construct the hyperplanes and a feasible point
 	vector<hyperplane_t*> utility_hyperplane;
@@ -148,7 +167,10 @@ vector<point_t*> get_extreme_pts(vector<point_t*>& ext_vec)
 		exit(0);
 	}
 	wPtr = (FILE *)fopen(file2, "w");
-	halfspace(rPtr, wPtr);
+	{
+		std::lock_guard<std::mutex> lock(qhull_mutex);
+		halfspace(rPtr, wPtr);
+	}
 	fclose(rPtr);
 	fclose(wPtr);
 
@@ -167,7 +189,9 @@ vector<point_t*> get_extreme_pts(vector<point_t*>& ext_vec)
 		point_t* p = alloc_point(dim);
 		for (int j = 0; j < dim; j++)
 		{
-			fscanf(rPtr, "%lf", &p->coord[j]);
+			double value;
+			fscanf(rPtr, "%lf", &value);
+			p->coord[j] = value;
 			if(!isZero(p->coord[j]))
 				allZero = false;
 		}
@@ -217,73 +241,64 @@ void print_summary(void) {
 
 }
 
-// get bounding hyperplanes of the conical hull (used in the conical hull pruning)
-void get_hyperplanes(vector<point_t*>& ext_vec, hyperplane_t*& hp, vector<point_t*>& hyperplanes)
+// the normal of a hyperplane that separates the extreme vectors from the origin (used in the necessary condition
+// of conical hull pruning): the sum of LP solutions, each of which is below all extreme vectors but one
+point_t* separating_normal(const vector<point_t*>& ext_vec)
 {
-	//constuct non-trivial extreme vectors
-	vector<int> frame;
-	frameConeLP(ext_vec, frame);
-	vector<point_t*> new_ext_vec;
-	for(int i = 0; i < frame.size(); i++)
-		new_ext_vec.push_back(copy(ext_vec[frame[i]]));
-	for(int i = 0; i < ext_vec.size(); i ++)
-		release_point(ext_vec[i]);
-	ext_vec = new_ext_vec;
-
 	int dim = ext_vec[0]->dim;
-	
-	// used in the necessary condiditon of conical hull pruning
+
 	double offset = 0;
 	point_t* normal = alloc_point(dim);
 	for(int i = 0; i < dim; i++)
 		normal->coord[i] = 0;
 
-	
-	if(1)
+	for(int i = 0; i < ext_vec.size(); i++)
 	{
-		for(int i = 0; i < ext_vec.size(); i++)
-		{
-			point_t* minus = scale(-1, ext_vec[i]);
-			double len;
-			point_t* pi = alloc_point(dim);
-
-			solveLP(ext_vec, minus, len, pi);
-
-			point_t* new_normal = add(normal, pi);
-
-			offset = dot_prod(normal, ext_vec[0]);
-			for (int i = 1; i < ext_vec.size(); i++)
-			{
-				double temp = dot_prod(normal, ext_vec[i]);
-				if (temp > offset)
-					offset = temp;
-			}
+		point_t* minus = scale(-1, ext_vec[i]);
+		double len;
+		point_t* pi = alloc_point(dim);
 
-			release_point(pi);
-			release_point(minus);
-			release_point(normal);
+		solveLP(ext_vec, minus, len, pi);
 
-			normal = new_normal;
+		point_t* new_normal = add(normal, pi);
 
-			if(offset < 0 && !isZero(offset))
-				break;
-		}
-
-		double length = calc_len(normal);
-		for(int i = 0; i < dim; i++)
-			normal->coord[i] /= -length;
 		offset = dot_prod(normal, ext_vec[0]);
 		for (int i = 1; i < ext_vec.size(); i++)
 		{
 			double temp = dot_prod(normal, ext_vec[i]);
-			if (temp < offset)
+			if (temp > offset)
 				offset = temp;
-		}	
+		}
+
+		release_point(pi);
+		release_point(minus);
+		release_point(normal);
+
+		normal = new_normal;
+
+		if(offset < 0 && !isZero(offset))
+			break;
 	}
 
-	// the hyperplane for the necessary condiditon of conical hull pruning
-	hp = alloc_hyperplane(normal, offset);
+	return normal;
+}
 
+// whether normal still separates the extreme vectors from the origin
+bool separates(point_t* normal, const vector<point_t*>& ext_vec)
+{
+	for(int i = 0; i < ext_vec.size(); i++)
+	{
+		double v = dot_prod(normal, ext_vec[i]);
+		if(v >= 0 || isZero(v))
+			return false;
+	}
+	return true;
+}
+
+// get bounding hyperplanes of the conical hull of the extreme vectors
+void conical_hull_hyperplanes(const vector<point_t*>& ext_vec, vector<point_t*>& hyperplanes)
+{
+	int dim = ext_vec[0]->dim;
 
 	// invoke Qhull for computing the conical hull
 	int n = ext_vec.size() + 1;
@@ -292,16 +307,11 @@ void get_hyperplanes(vector<point_t*>& ext_vec, hyperplane_t*& hp, vector<point_
 	boolT ismalloc = True;
 
 	coordT *points;
-	//temp_points = new coordT[(orthNum * S->numberOfPoints + 1)*(dim)];
+	std::lock_guard<std::mutex> lock(qhull_mutex);
 	points = qh temp_malloc = (coordT*)qh_malloc(n*(dim)*sizeof(coordT));
 
 	for (int i = 0; i < ext_vec.size(); i++)
 	{
-		//double len = compute_intersection_len(hp, ext_vec[i]);
-		//printf("%lf %lf\n", len, calc_len(ext_vec[i]));
-		//point_t* tmp = scale( len, ext_vec[i]);
-		//for (int j = 0; j < dim; j++)
-		//	points[i*dim + j] = tmp->coord[j];
 		for (int j = 0; j < dim; j++)
 			points[i*dim + j] = ext_vec[i]->coord[j];
 	}
@@ -311,59 +321,21 @@ void get_hyperplanes(vector<point_t*>& ext_vec, hyperplane_t*& hp, vector<point_
 		points[ext_vec.size()*dim + i] = 0;
 	}
 
-	//printf("# of points: %d\n", count);
 	qh_init_A(stdin, stdout, stderr, 0, NULL);  /* sets qh qhull_command */
 	exitcode = setjmp(qh errexit); /* simple statement for CRAY J916 */
 
-	double minCR;
-
 	if (!exitcode) {
-
-		//qh POSTmerge = True;
-		////qh postmerge_centrum = 0.01;
-		//qh premerge_cos = 0.995;
-
 		qh_initflags(qh qhull_command);
 		qh_init_B(points, n, dim, ismalloc);
 		qh_qhull();
 		qh_check_output();
-
+		metric_add(METRIC_QHULL_CALLS);
+		metric_add(METRIC_QHULL_VERTICES, qh num_vertices);
 
 		if (qh VERIFYoutput && !qh FORCEoutput && !qh STOPpoint && !qh STOPcone)
 			qh_check_points();
 		exitcode = qh_ERRnone;
 
-		//qh_vertexneighbors();
-		//print_summary();
-
-
-		//vertexT *vertex;
-		//FORALLvertices
-		//{
-		//	bool isPt = true;
-		//	for (int i = 0; i < dim; i++)
-		//	{
-		//		if (!isZero(vertex->point[i]))
-		//		{
-		//			isPt = false;
-		//			break;
-		//		}
-		//	}
-
-		//	if (isPt)
-		//	{
-		//		facetT *facet, **facetp;
-		//		FOREACHfacet_(vertex->neighbors)
-		//		{
-		//			point_t* normal = alloc_point(dim);
-		//			for (int j = 0; j < dim; j++)
-		//				normal->coord[j] = facet->normal[j];
-		//			hyperplanes.push_back(normal);
-		//		}
-		//		break;
-		//	}
-		//}
-
 		// the bounding hyperplaines of the conical hull
 		facetT *facet;
 		FORALLfacets{
@@ -393,8 +365,240 @@ void get_hyperplanes(vector<point_t*>& ext_vec, hyperplane_t*& hp, vector<point_
 
 }
 
+// whether the frame vector f stays extreme when the extreme vectors from first on are added: it does if a bounding
+// hyperplane through f has all of them strictly below it, as the face of the hull on that hyperplane is unchanged
+bool stays_extreme(point_t* f, const vector<point_t*>& hyperplanes, const vector<point_t*>& ext_vec, int first)
+{
+	for(int i = 0; i < hyperplanes.size(); i++)
+	{
+		if(!isZero(dot_prod(hyperplanes[i], f)))
+			continue;
+
+		bool below = true;
+		for(int j = first; j < ext_vec.size() && below; j++)
+		{
+			double v = dot_prod(hyperplanes[i], ext_vec[j]);
+			below = v < 0 && !isZero(v);
+		}
+		if(below)
+			return true;
+	}
+	return false;
+}
+
+void release_conical_hull_cache(conical_hull_cache& cache)
+{
+	cache.frame.clear();
+	if(cache.normal != NULL)
+		release_point(cache.normal);
+	cache.normal = NULL;
+	if(cache.hp != NULL)
+		release_point(cache.hp->normal);
+	release_hyperplane(cache.hp);
+	for(int i = 0; i < cache.hyperplanes.size(); i++)
+		release_point(cache.hyperplanes[i]);
+	cache.hyperplanes.clear();
+	for(int i = 0; i < cache.ext_pts.size(); i++)
+		release_point(cache.ext_pts[i]);
+	cache.ext_pts.clear();
+	cache.has_ext_pts = false;
+}
+
+// reduce ext_vec to its frame and get the bounding hyperplanes of its conical hull (used in the conical hull pruning),
+// and the extreme points of R if need_ext_pts
+// the extreme rays of R are the normals of the bounding hyperplanes, so that its extreme points need no half space
+// intersection
+void update_conical_hull(vector<point_t*>& ext_vec, conical_hull_cache& cache, bool need_ext_pts)
+{
+	// the extreme vectors from first on were added since the last pruning
+	int first = cache.frame.size();
+	bool cached = first > 0 && first <= ext_vec.size();
+	for(int i = 0; i < first && cached; i++)
+		cached = ext_vec[i] == cache.frame[i];
+	if(!cached)
+	{
+		release_conical_hull_cache(cache);
+		first = 0;
+	}
+
+	// constuct non-trivial extreme vectors, as frameConeLP, but without an LP for the old ones that stay extreme
+	int dim = ext_vec[0]->dim;
+	point_t* zero = alloc_point(dim);
+	for (int i = 0; i < dim; i++)
+		zero->coord[i] = 0;
+
+	vector<point_t*> rays = ext_vec;
+	vector<point_t*> new_ext_vec;
+	for(int i = 0; i < rays.size(); i++)
+	{
+		point_t* ray = rays[i];
+		if(i < first && stays_extreme(ray, cache.hyperplanes, ext_vec, first))
+		{
+			new_ext_vec.push_back(ray);
+			continue;
+		}
+
+		rays[i] = zero;
+		if (!insideCone(rays, ray))
+		{
+			new_ext_vec.push_back(ray);
+			rays[i] = ray;
+		}
+	}
+	release_point(zero);
+
+	// the frame is unchanged if it keeps the old extreme vectors only, all of them
+	bool changed = !cached || new_ext_vec.size() != first;
+	for(int i = 0; i < ext_vec.size(); i++)
+	{
+		if(rays[i] != ext_vec[i])
+		{
+			release_point(ext_vec[i]);
+			changed = changed || i < first;
+		}
+	}
+	ext_vec = new_ext_vec;
+	cache.frame = ext_vec;
+
+	if(changed)
+	{
+		// the last normal is kept for the necessary condition while it separates the new frame from the origin
+		if(cache.normal == NULL || !separates(cache.normal, ext_vec))
+		{
+			if(cache.normal != NULL)
+				release_point(cache.normal);
+			cache.normal = separating_normal(ext_vec);
+		}
+
+		// the hyperplane for the necessary condiditon of conical hull pruning
+		point_t* normal = alloc_point(dim);
+		double length = calc_len(cache.normal);
+		for(int i = 0; i < dim; i++)
+			normal->coord[i] = cache.normal->coord[i] / -length;
+		double offset = dot_prod(normal, ext_vec[0]);
+		for (int i = 1; i < ext_vec.size(); i++)
+		{
+			double temp = dot_prod(normal, ext_vec[i]);
+			if (temp < offset)
+				offset = temp;
+		}
+		if(cache.hp != NULL)
+			release_point(cache.hp->normal);
+		release_hyperplane(cache.hp);
+		cache.hp = alloc_hyperplane(normal, offset);
+
+		for(int i = 0; i < cache.hyperplanes.size(); i++)
+			release_point(cache.hyperplanes[i]);
+		cache.hyperplanes.clear();
+		conical_hull_hyperplanes(ext_vec, cache.hyperplanes);
+
+		for(int i = 0; i < cache.ext_pts.size(); i++)
+			release_point(cache.ext_pts[i]);
+		cache.ext_pts.clear();
+		cache.has_ext_pts = false;
+	}
+
+	if(need_ext_pts && !cache.has_ext_pts)
+	{
+		// the point of each extreme ray of R on the hyperplane sum(u) = 1
+		for(int i = 0; i < cache.hyperplanes.size(); i++)
+		{
+			double sum = 0;
+			for(int j = 0; j < dim; j++)
+				sum += cache.hyperplanes[i]->coord[j];
+			if(sum > 0 && !isZero(sum))
+				cache.ext_pts.push_back(scale(1 / sum, cache.hyperplanes[i]));
+		}
+
+		// without a hull, as before
+		if(cache.hyperplanes.empty())
+		{
+			cache.ext_pts = get_extreme_pts(ext_vec);
+			cache.frame = ext_vec;
+		}
+		cache.has_ext_pts = true;
+	}
+}
+
+// the number of utility vectors kept by halfspace pruning besides the center of R
+#define HALFSPACE_WITNESSES 32
+
+// the candidate utility range R in halfspace pruning, given by the extreme vectors only
+// a dominance test first looks for a utility vector of R on which the other point is better among the center of R and
+// the minimizers of earlier tests, and solves an LP only if there is none
+struct halfspace_range
+{
+	vector<point_t*>* ext_vec;
+	bool empty;
+	vector<point_t*> witnesses;	// the center of R, then the kept utility vectors
+	int witness_count;			// the witnesses in use
+	int next_witness;			// the slot of the next minimizer
+};
+
+// the witnesses are allocated here, outside of the arena scopes of the dominance tests
+void init_halfspace_range(halfspace_range& range, vector<point_t*>& ext_vec)
+{
+	int dim = ext_vec[0]->dim;
+
+	range.ext_vec = &ext_vec;
+	for(int i = 0; i <= HALFSPACE_WITNESSES; i++)
+		range.witnesses.push_back(alloc_point(dim));
+	range.empty = utility_range_center(ext_vec, range.witnesses[0]) < 0;
+	range.witness_count = 1;
+	range.next_witness = 1;
+}
+
+void release_halfspace_range(halfspace_range& range)
+{
+	for(int i = 0; i < range.witnesses.size(); i++)
+		release_point(range.witnesses[i]);
+	range.witnesses.clear();
+}
+
+// halfspace pruning
+// the same test as hyperplane pruning: the minimum of (p_i - p_j).u over R is attained at an extreme point of R
+int halfspace_dom(point_t* p_i, point_t* p_j, halfspace_range& range)
+{
+	// as in hyperplane pruning, which finds no extreme points
+	if(range.empty)
+		return 1;
+
+	point_t* normal = sub(p_i, p_j);
+	int dominate = 1;
+
+	for(int i = 0; i < range.witness_count; i++)
+	{
+		double v = dot_prod(normal, range.witnesses[i]);
+		if(v < 0 && !isZero(v))
+		{
+			dominate = 0;
+			break;
+		}
+	}
+
+	if(dominate)
+	{
+		// every utility vector of R may be kept, so the minimizer goes straight into its slot
+		// R is not empty, so an LP that fails keeps p_j rather than prune it
+		double v;
+		bool solved = utility_range_min(*range.ext_vec, normal, v, range.witnesses[range.next_witness]);
+		if(!solved)
+			dominate = 0;
+		else if(v < 0 && !isZero(v))
+		{
+			dominate = 0;
+			if(range.witness_count <= HALFSPACE_WITNESSES)
+				range.witness_count++;
+			range.next_witness = range.next_witness % HALFSPACE_WITNESSES + 1;
+		}
+	}
+	release_point(normal);
+
+	return dominate;
+}
+
 // hyperplane pruning
-int hyperplane_dom(point_t* p_i, point_t* p_j, vector<point_t*> ext_pts)
+int hyperplane_dom(point_t* p_i, point_t* p_j, const vector<point_t*>& ext_pts)
 {
 	int dim = p_i->dim;
 
@@ -423,7 +627,7 @@ int hyperplane_dom(point_t* p_i, point_t* p_j, vector<point_t*> ext_pts)
 }
 
 // conical hull pruning
-int conical_hull_dom(point_t* p_i, point_t* p_j, hyperplane_t* hp, vector<point_t*> hyperplanes, vector<point_t*> ext_vec)
+int conical_hull_dom(point_t* p_i, point_t* p_j, hyperplane_t* hp, const vector<point_t*>& hyperplanes)
 {
 	int dim = p_i->dim;
 	int dominate;
@@ -463,13 +667,15 @@ int conical_hull_dom(point_t* p_i, point_t* p_j, hyperplane_t* hp, vector<point_
 	return dominate;
 }
 
-// check whether p_i has a higher uitlity than p_j based on either Hyperplane Prunning or Conical Hull Pruninig (defined by dom_option)
-int dom(point_t* p_i, point_t* p_j, vector<point_t*> ext_pts, hyperplane_t* hp, vector<point_t*> hyperplanes, vector<point_t*> ext_vec, int dom_option)
+// check whether p_i has a higher uitlity than p_j based on Hyperplane Prunning, Conical Hull Pruninig or Halfspace Pruning (defined by dom_option)
+int dom(point_t* p_i, point_t* p_j, const vector<point_t*>& ext_pts, const conical_hull_cache& conical, halfspace_range& range, int dom_option)
 {
 	if(dom_option == HYPER_PLANE) // hyperplane pruning
 		return hyperplane_dom(p_i, p_j, ext_pts);
+	else if(dom_option == HALFSPACE) // halfspace pruning
+		return halfspace_dom(p_i, p_j, range);
 	else // conical hull pruning
-		return conical_hull_dom(p_i, p_j, hp, hyperplanes, ext_vec);
+		return conical_hull_dom(p_i, p_j, conical.hp, conical.hyperplanes);
 }
 
 // get an approximate upper bound bound in O(|ext_pts|) time based on the MBR of R
@@ -539,33 +745,72 @@ double get_rrbound_exact(vector<point_t*> ext_pts)
 	return max < 1? max : 1;
 }
 
+// get the approximate upper bound without the extreme points of R: the bounding box of R is that of its extreme
+// points, and its sides are found with 2d LPs on the extreme vectors
+double get_rrbound_lp(vector<point_t*>& ext_vec)
+{
+	int dim = ext_vec[0]->dim;
+	point_t* c = alloc_point(dim);
+	for(int i = 0; i < dim; i++)
+		c->coord[i] = 0;
+
+	double bound = 0;
+	bool empty = false;
+	for(int i = 0; i < dim && !empty; i++)
+	{
+		double min, minus_max;
+		c->coord[i] = 1;
+		empty = !utility_range_min(ext_vec, c, min, NULL);
+		c->coord[i] = -1;
+		empty = empty || !utility_range_min(ext_vec, c, minus_max, NULL);
+		c->coord[i] = 0;
+
+		bound += -minus_max - min;
+	}
+	release_point(c);
+
+	// as get_rrbound_approx without extreme points
+	if(empty)
+		return 1;
+
+	bound *= dim;
+
+	return bound < 1? bound: 1;
+}
+
 // use the seqentail way for maintaining the candidate set
 // P: the input car set
 // C_idx: the indexes of the current candidate favorite car in P
 // ext_vec: the set of extreme vecotr
 // rr: the upper bound of the regret ratio
 // stop_option: the stopping condition, which can be NO_BOUND, EXACT_BOUND and APPROX_BOUND
-// dom_option: the skyline options, which can be SQL or RTREE
-void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr, int stop_option, int dom_option)
+// dom_option: the domination options, which can be HYPER_PLANE, CONICAL_HULL or HALFSPACE
+// cache: the conical hull pruning state of the earlier prunings of ext_vec, if any
+void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr, int stop_option, int dom_option, conical_hull_cache* cache)
 {
 	int dim = P->points[0]->dim;
 
 	vector<point_t*> ext_pts;
-	vector<point_t*> hyperplanes;
-	hyperplane_t* hp = NULL;
+	conical_hull_cache local_cache;
+	conical_hull_cache& conical = cache != NULL? *cache : local_cache;
+	halfspace_range range;
 	
 	if(dom_option == HYPER_PLANE)
 		ext_pts = get_extreme_pts(ext_vec); // in Hyperplane Pruning, we need the set of extreme points of R
+	else if(dom_option == HALFSPACE)
+		init_halfspace_range(range, ext_vec); // in Halfspace Pruning, we need the center of R only
 	else
 	{
 		// in Conical Pruning, we need bounding hyperplanes for the conical hull
-		get_hyperplanes(ext_vec, hp, hyperplanes); 
-		if(stop_option != NO_BOUND) // if an upper bound on the regret ratio is needed, we need the set of extreme points of R
-			ext_pts = get_extreme_pts(ext_vec);
+		// if an upper bound on the regret ratio is needed, we need the set of extreme points of R
+		update_conical_hull(ext_vec, conical, stop_option != NO_BOUND);
+		ext_pts = conical.ext_pts;
 	}
 
 	// get the upper bound of the regret ratio based on (the extreme ponits of) R
-	if(stop_option == EXACT_BOUND)
+	if(dom_option == HALFSPACE && stop_option != NO_BOUND)
+		rr = get_rrbound_lp(ext_vec);
+	else if(stop_option == EXACT_BOUND)
 		rr = get_rrbound_exact(ext_pts);
 	else if (stop_option == APPROX_BOUND)
 		rr = get_rrbound_approx(ext_pts);
@@ -588,6 +833,8 @@ void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec,
 
 	for (int i = 0; i < C_idx.size(); ++i)
 	{
+		// the dominance tests allocate temporary vectors only
+		point_arena_scope scope;
 
 		int dominated = 0;
 		point_t* pt = P->points[C_idx[i]];
@@ -596,7 +843,7 @@ void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec,
 		for (int j = 0; j < index && !dominated; ++j)
 		{
 
-			if(dom(P->points[ sl[j] ], pt, ext_pts, hp, hyperplanes, ext_vec, dom_option))
+			if(dom(P->points[ sl[j] ], pt, ext_pts, conical, range, dom_option))
 				dominated = 1;
 		}
 
@@ -608,7 +855,7 @@ void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec,
 			for (int j = 0; j < m; ++j)
 			{
 
-				if(!dom(pt, P->points[sl[j]], ext_pts, hp, hyperplanes, ext_vec, dom_option))
+				if(!dom(pt, P->points[sl[j]], ext_pts, conical, range, dom_option))
 					sl[index++] = sl[j];
 			}
 
@@ -628,11 +875,13 @@ void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec,
 		for(int i = 0; i < ext_pts.size(); i++)
 			release_point(ext_pts[i]);
 	}
-	else
+	else if(dom_option == HALFSPACE)
 	{
-		release_hyperplane(hp);
-		for(int i = 0; i < hyperplanes.size(); i++)
-			release_point(hyperplanes[i]);
+		release_halfspace_range(range);
+	}
+	else if(cache == NULL)
+	{
+		release_conical_hull_cache(conical);
 	}
 	
 }
@@ -643,25 +892,31 @@ void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec,
 // ext_vec: the set of extreme vecotr
 // rr: the upper bound of the regret ratio
 // stop_option: the stopping condition, which can be NO_BOUND, EXACT_BOUND and APPROX_BOUND
-// dom_option: the skyline options, which can be SQL or RTREE
-void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr,  int stop_option, int dom_option)
+// dom_option: the domination options, which can be HYPER_PLANE, CONICAL_HULL or HALFSPACE
+// cache: the conical hull pruning state of the earlier prunings of ext_vec, if any
+void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr,  int stop_option, int dom_option, conical_hull_cache* cache)
 {
 	vector<point_t*> ext_pts;
-	vector<point_t*> hyperplanes;
-	hyperplane_t* hp = NULL;
+	conical_hull_cache local_cache;
+	conical_hull_cache& conical = cache != NULL? *cache : local_cache;
+	halfspace_range range;
 	
 	if(dom_option == HYPER_PLANE)
 		ext_pts = get_extreme_pts(ext_vec); // in Hyperplane Pruning, we need the set of extreme points of R
+	else if(dom_option == HALFSPACE)
+		init_halfspace_range(range, ext_vec); // in Halfspace Pruning, we need the center of R only
 	else
 	{
 		// in Conical Pruning, we need bounding hyperplanes for the conical hull
-		get_hyperplanes(ext_vec, hp, hyperplanes); 
-		if(stop_option != NO_BOUND) // if a upper bound on the regret ratio is needed, we need the set of extreme points of R
-			ext_pts = get_extreme_pts(ext_vec);
+		// if an upper bound on the regret ratio is needed, we need the set of extreme points of R
+		update_conical_hull(ext_vec, conical, stop_option != NO_BOUND);
+		ext_pts = conical.ext_pts;
 	}
 	
 	// get the upper bound of the regret ratio based on (the extreme ponits of) R
-	if(stop_option == EXACT_BOUND)
+	if(dom_option == HALFSPACE && stop_option != NO_BOUND)
+		rr = get_rrbound_lp(ext_vec);
+	else if(stop_option == EXACT_BOUND)
 		rr = get_rrbound_exact(ext_pts);
 	else if (stop_option == APPROX_BOUND)
 		rr = get_rrbound_approx(ext_pts);
@@ -692,6 +947,8 @@ void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec
 	// run the adapted BBS algorihtm
 	while (!heap.empty())
 	{
+		// the dominance tests and the corner points of the nodes are temporaries
+		point_arena_scope scope;
 		node_type* n = heap.top();
 		heap.pop();
 
@@ -708,7 +965,7 @@ void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec
 			for (int j = 0; j < index && !dominated; ++j)
 			{
 				
-				if(dom(P->points[ sl[j] ], TRpt, ext_pts, hp, hyperplanes, ext_vec, dom_option))
+				if(dom(P->points[ sl[j] ], TRpt, ext_pts, conical, range, dom_option))
 					dominated = 1;
 
 			}
@@ -741,7 +998,7 @@ void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec
 			int dominated = 0;
 			for (int j = 0; j < index && !dominated; ++j)
 			{
-				if(dom(P->points[ sl[j] ], P->points[ C_idx[idx] ], ext_pts, hp, hyperplanes, ext_vec, dom_option))
+				if(dom(P->points[ sl[j] ], P->points[ C_idx[idx] ], ext_pts, conical, range, dom_option))
 					dominated = 1;
 			}
 			if (dominated)
@@ -752,7 +1009,7 @@ void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec
 			index = 0;
 			for (int j = 0; j < m; ++j)
 			{
-				if(!dom(P->points[C_idx[idx]], P->points[sl[j]], ext_pts, hp, hyperplanes, ext_vec, dom_option))
+				if(!dom(P->points[C_idx[idx]], P->points[sl[j]], ext_pts, conical, range, dom_option))
 					sl[index++] = sl[j];
 			}
 
@@ -772,10 +1029,12 @@ void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec
 		for(int i = 0; i < ext_pts.size(); i++)
 			release_point(ext_pts[i]);
 	}
-	else
+	else if(dom_option == HALFSPACE)
 	{
-		release_hyperplane(hp);
-		for(int i = 0; i < hyperplanes.size(); i++)
-			release_point(hyperplanes[i]);
+		release_halfspace_range(range);
+	}
+	else if(cache == NULL)
+	{
+		release_conical_hull_cache(conical);
 	}
 }
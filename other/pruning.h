@@ -10,10 +10,14 @@
 #include "frame.h"
 #include "read_write.h"
 #include <queue>
+#include <mutex>
 
 // the domination options
 #define HYPER_PLANE 1
 #define CONICAL_HULL 2
+// works on the extreme vectors (the halfspaces of R) only and never on the extreme points of R: dominance is tested
+// with LPs, and both bounds are the approximate bound, from the bounding box of R found with LPs
+#define HALFSPACE 3
 
 // the skyline options
 #define SQL 1
@@ -26,13 +30,38 @@
 
 using namespace std;
 
+// qhull keeps its state in globals, so every qhull run must hold this lock
+extern std::mutex qhull_mutex;
+
 // get the set of extreme points of the candidate utility range R (bounded by the extreme vectors)
 vector<point_t*> get_extreme_pts(vector<point_t*>& ext_vec);
 
+// get an upper bound of the regret ratio from the bounding box of R, with 2d LPs on the extreme vectors
+double get_rrbound_lp(vector<point_t*>& ext_vec);
+
+// the state of conical hull pruning on the extreme vectors of one candidate utility range, kept between rounds
+// the extreme vectors only grow between two prunings, so only the new ones are tested against the frame of the last
+// pruning, and the hull is recomputed only if the frame changes
+struct conical_hull_cache
+{
+	vector<point_t*> frame;			// the extreme vectors after the last pruning, owned by ext_vec
+	point_t* normal;				// the sum of the LP solutions that separates the frame from the origin
+	hyperplane_t* hp;				// the hyperplane of the necessary condition
+	vector<point_t*> hyperplanes;	// the bounding hyperplanes of the conical hull of the frame
+	bool has_ext_pts;
+	vector<point_t*> ext_pts;		// the extreme points of R, if has_ext_pts
+
+	conical_hull_cache() : normal(NULL), hp(NULL), has_ext_pts(false) {}
+};
+
+// release the hull and the extreme points kept in cache (but not the frame)
+void release_conical_hull_cache(conical_hull_cache& cache);
+
 // use the seqentail way for maintaining the candidate set
-void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr, int stop_option, int dom_option);
+// with conical hull pruning, cache (if any) must be the cache of the earlier prunings of ext_vec
+void sql_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr, int stop_option, int dom_option, conical_hull_cache* cache = NULL);
 
 // use the branch-and-bound skyline (BBS) algorithm for maintaining the candidate set
-void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr,  int stop_option, int dom_option);
+void rtree_pruning(point_set_t* P, vector<int>& C_idx, vector<point_t*>& ext_vec, double& rr,  int stop_option, int dom_option, conical_hull_cache* cache = NULL);
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "rtree.h"
+#include "metrics.h"
 
 void q_swap(int *sorted_index, double *value, int i, int j)
 {
@@ -1229,6 +1230,7 @@ node_type* contructRtree(point_set_t* C, rtree_info *aInfo)
 	}
 
 	build_tree(&root, data, no_data, aInfo);
+	metric_add(METRIC_RTREE_BUILDS);
 
 	return root;
 }
@@ -1251,6 +1253,7 @@ node_type* contructRtree(point_set_t* P, std::vector<int> C_idx, rtree_info *aIn
 	}
 
 	build_tree(&root, data, no_data, aInfo);
+	metric_add(METRIC_RTREE_BUILDS);
 
 	return root;
 }
\ No newline at end of file
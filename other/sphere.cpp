@@ -143,12 +143,12 @@ void basisComputation(point_set_t*& X, point_t*& NN, point_t* p, point_t* x)
 			double lambda = sol[m - 1];
 
 			//find the minimum non-negative lambda
-			if ((isZero(lambda) || lambda > 0) && maxLambda < -0.5)
+			if ((isCoordZero(lambda) || lambda > 0) && maxLambda < -0.5)
 			{
 				maxLambda = lambda;
 				maxT = t;
 			}
-			else if (maxLambda > -0.5 && lambda > 0 && !isZero(lambda))
+			else if (maxLambda > -0.5 && lambda > 0 && !isCoordZero(lambda))
 			{
 				if (lambda < maxLambda)
 				{
@@ -161,7 +161,7 @@ void basisComputation(point_set_t*& X, point_t*& NN, point_t* p, point_t* x)
 		release_point_set(X_tmp, false);
 
 		// X is indeed the P-basis
-		if (maxLambda > 1 && !isZero(maxLambda - 1))
+		if (maxLambda > 1 && !isCoordZero(maxLambda - 1))
 		{
 			release_point(NN);
 			NN = q_X;
@@ -229,8 +229,13 @@ void search_basis(point_set_t* P, point_set_t* T, point_t* NN_T, point_t* x, poi
 		// The violation test: check whether we can improve the distance by incorporate p 
 		if (isViolated(x, NN_X, p))
 		{
+			double dist = calc_dist(x, NN_X);
 			basisComputation(X, NN_X, p, x);
 
+			// recurse only while the distance to x shrinks; rounding of single-precision coordinates can stall the update
+			if (!(calc_dist(x, NN_X) < dist - COORD_EPS))
+				continue;
+
 			point_set_t* newX;
 			point_t* newNN_X;
 
@@ -308,8 +313,10 @@ point_set_t* sphereWSImpLP(point_set_t* point_set, int k)
 		I = construct_I(dim, k - dim);
 
 		// Step 3: For each point in I, search its P-basic
-		for (int i = 0; i < I->numberOfPoints; i++)
+		for (int i = 0; i < I->numberOfPoints && !cancellation_requested(); i++)
 		{
+			// the basis search only keeps pointers to input points, its temporaries go to the arena
+			point_arena_scope scope;
 			point_set_t* basis = search_basis(point_set, I->points[i]);
 
 			for (int j = 0; j < basis->numberOfPoints; j++)
@@ -384,7 +391,7 @@ point_set_t* sphereWSImpLP(point_set_t* point_set, int k)
 	result->points[count++] = max;
 	lastRound_max = max;
 
-	while (count < k)
+	while (count < k && !cancellation_requested())
 	{
 		// Find a point with maximum regret
 		max = NULL;
@@ -6,6 +6,7 @@
 #include "operation.h"
 
 #include "lp.h"
+#include "cancellation.h"
 
 // The complete Sphere algorithm
 point_set_t* sphereWSImpLP(point_set_t* point_set, int k);
@@ -0,0 +1,664 @@
+#include "session_server.h"
+#include "experiment.h"
+#include "highdim.h"
+#include "json_lines.h"
+#include "other/kernel_threads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// the phase 3 projections kept per dataset
+const int PROJECTION_CACHE_SIZE = 32;
+// the number of most recent requests the latency percentiles of the server are taken over
+const size_t LATENCY_WINDOW = 10000;
+
+// a loaded dataset, with the skyline sharing its points; the sessions on it hold it, so it outlives the registry entry
+struct served_dataset{
+    point_set_t* dataset = nullptr;
+    point_set_t* skyline = nullptr;
+    std::unique_ptr<highdim_projection_cache> projections;
+
+    ~served_dataset(){
+        projections.reset();
+        release_experiment_dataset(skyline, dataset);
+    }
+};
+
+// the datasets of the server: those given on startup are kept until shutdown, those that sessions name are loaded on
+// first use and the least recently used of them are dropped beyond the capacity, once their last session is over
+class dataset_registry{
+public:
+    dataset_registry(int capacity, bool hull) : capacity_(capacity < 1 ? 1 : capacity), hull_(hull) {}
+
+    // keep the dataset at path until shutdown; false if it cannot be read
+    bool preload(const std::string& path){
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<served_dataset> data = load(path);
+        if (!data) return false;
+        preloaded_[path] = data;
+        return true;
+    }
+
+    // the prepared dataset at path; nullptr if it cannot be read
+    std::shared_ptr<served_dataset> get(const std::string& path){
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = preloaded_.find(path);
+        if (found != preloaded_.end()) return found->second;
+        for (auto it = recent_.begin(); it != recent_.end(); ++it){
+            if (it->first == path){
+                recent_.splice(recent_.begin(), recent_, it);
+                return it->second;
+            }
+        }
+        std::shared_ptr<served_dataset> data = load(path);
+        if (!data) return nullptr;
+        recent_.emplace_front(path, data);
+        if (recent_.size() > capacity_) recent_.pop_back();
+        return data;
+    }
+
+private:
+    // the path comes with a request, so it is checked rather than left to read_points, which exits
+    std::shared_ptr<served_dataset> load(const std::string& path){
+        std::shared_ptr<served_dataset> data = std::make_shared<served_dataset>();
+        data->skyline = load_experiment_dataset(path, &data->dataset, hull_);
+        if (data->skyline == nullptr) return nullptr;
+        data->projections.reset(new highdim_projection_cache(data->skyline, PROJECTION_CACHE_SIZE));
+        return data;
+    }
+
+    size_t capacity_;
+    bool hull_;
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<served_dataset>> preloaded_;
+    std::list<std::pair<std::string, std::shared_ptr<served_dataset>>> recent_;    // the most recent one at the front
+};
+
+// the response latencies of a session or of the server, in milliseconds
+struct latency_summary{
+    long requests = 0;
+    double total = 0;
+    double max = 0;
+
+    void add(double latency){
+        requests++;
+        total += latency;
+        max = std::max(max, latency);
+    }
+};
+
+void format_latency(std::ostringstream& out, const latency_summary& latency){
+    out << "\"requests\":" << latency.requests
+        << ",\"mean_latency_ms\":" << (latency.requests > 0 ? latency.total / latency.requests : 0)
+        << ",\"max_latency_ms\":" << latency.max;
+}
+
+// where the responses to the requests of one client go; the lines of concurrent sessions do not interleave
+struct client_stream{
+    FILE* out;
+    bool owned;     // out is closed with the last reference to the client
+    std::mutex mutex;
+
+    client_stream(FILE* stream, bool owns_stream) : out(stream), owned(owns_stream) {}
+    ~client_stream(){ if (owned) fclose(out); }
+    void write(const std::string& line){
+        std::lock_guard<std::mutex> lock(mutex);
+        fputs(line.c_str(), out);
+        fflush(out);
+    }
+};
+
+// the pending question of a session answered in advance, while its user thinks
+struct speculation{
+    enum speculation_state { QUEUED, RUNNING, DONE, CANCELLED };
+
+    int answer;
+    std::shared_ptr<served_dataset> data;       // of the session, which a running clone may outlive
+    std::unique_ptr<highdim_session> session;   // a clone of the session, which receives the answer
+    speculation_state state = QUEUED;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    // true if the caller is the one to run it: it is neither started nor cancelled
+    bool claim(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state != QUEUED) return false;
+        state = RUNNING;
+        return true;
+    }
+    void run(){
+        session->submit_answer(answer);
+        session->next_question();
+        std::lock_guard<std::mutex> lock(mutex);
+        state = DONE;
+        done.notify_all();
+    }
+    void wait(){
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this](){ return state == DONE; });
+    }
+    // a running speculation is left to finish, and then dropped; a queued one releases its clone (and with it the
+    // projection the clone shares) at once, as it may wait in the queue for long
+    void cancel(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state != QUEUED) return;
+        state = CANCELLED;
+        session.reset();
+        data.reset();
+    }
+    bool cancelled(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return state == CANCELLED;
+    }
+};
+
+struct session_request{
+    json_object request;
+    std::shared_ptr<client_stream> client;
+    std::chrono::steady_clock::time_point received;
+};
+
+struct session_entry{
+    std::string id;    // escaped
+    std::shared_ptr<served_dataset> data;  // of the session, which it outlives
+    std::unique_ptr<highdim_session> session;
+    int question_budget = 0;
+    int batch = 0;      // the most questions in a response, 0 for responses with a single question
+    size_t batched = 0; // the questions in the last response
+    std::deque<session_request> pending;
+    bool busy = false;  // queued for or held by a worker
+    latency_summary latency;
+    std::vector<std::shared_ptr<speculation>> speculations;    // of the pending question
+};
+
+std::string format_error(const std::string& session_id, const char* reason){
+    std::ostringstream out;
+    out << "SESSION_ERROR {\"session\":\"" << session_id << "\",\"reason\":\"" << reason << "\"}\n";
+    return out.str();
+}
+
+template <typename T>
+void format_list(std::ostringstream& out, const T& values){
+    out << "[";
+    bool first = true;
+    for (auto value : values){
+        if (!first) out << ",";
+        out << value;
+        first = false;
+    }
+    out << "]";
+}
+
+void format_question(std::ostringstream& out, const highdim_question& question){
+    out << "\"dimension_question\":" << (question.dimension_question ? "true" : "false") << ",\"dimensions\":";
+    format_list(out, question.dimensions);
+    std::vector<int> ids;
+    for (point_t* p : question.points) ids.push_back(p->id);
+    out << ",\"points\":";
+    format_list(out, ids);
+    out << ",\"values\":[";
+    for (size_t i = 0; i < question.points.size(); ++i){
+        std::vector<double> values;
+        for (int dim : question.dimensions) values.push_back(question.points[i]->coord[dim]);
+        if (i > 0) out << ",";
+        format_list(out, values);
+    }
+    out << "],\"allow_none\":" << (question.allow_none ? "true" : "false");
+}
+
+// the pending question of the session (with the phase 1 questions after it for a batch session), or its result (or
+// error) once it is finished
+std::string format_progress(session_entry& entry){
+    std::ostringstream out;
+    out << std::setprecision(17);
+    if (entry.batch > 0){
+        const std::vector<highdim_question>& questions = entry.session->next_questions(entry.batch);
+        entry.batched = questions.size();
+        if (!questions.empty()){
+            out << "SESSION_QUESTIONS {\"session\":\"" << entry.id << "\",\"questions\":[";
+            for (size_t i = 0; i < questions.size(); ++i){
+                out << (i > 0 ? ",{" : "{");
+                format_question(out, questions[i]);
+                out << "}";
+            }
+            out << "],\"remaining_questions\":" << entry.session->remaining_questions() << "}\n";
+            return out.str();
+        }
+    }
+    else if (const highdim_question* question = entry.session->next_question()){
+        entry.batched = 1;
+        out << "SESSION_QUESTION {\"session\":\"" << entry.id << "\",";
+        format_question(out, *question);
+        out << ",\"remaining_questions\":" << entry.session->remaining_questions() << "}\n";
+        return out.str();
+    }
+    const highdim_output& output = entry.session->result();
+    if (output.error != nullptr) return format_error(entry.id, output.error);
+    std::vector<int> ids;
+    for (int i = 0; i < output.S->numberOfPoints; ++i) ids.push_back(output.S->points[i]->id);
+    double compute_seconds = 0;
+    for (int i = 0; i < METRIC_TIMER_COUNT; ++i) compute_seconds += entry.session->seconds(metric_timer(i));
+    out << "SESSION_RESULT {\"session\":\"" << entry.id << "\",\"points\":";
+    format_list(out, ids);
+    out << ",\"dimensions\":";
+    format_list(out, output.final_dimensions);
+    out << ",\"questions\":" << entry.question_budget - entry.session->remaining_questions()
+        << ",\"compute_seconds\":" << compute_seconds << "}\n";
+    return out.str();
+}
+
+// the parameters of an open request, as in run_experiment_trial; false if one is missing or out of range
+bool read_session_parameters(const json_object& request, highdim_parameters& parameters){
+    const char* required[] = {"m", "w", "K", "q"};
+    for (const char* key : required){
+        if (request.find(key) == request.end()) return false;
+    }
+    parameters.size = json_int(request, "size", 2);
+    parameters.d_bar = json_int(request, "d_bar", 5);
+    parameters.d_hat = json_int(request, "m", 0);
+    parameters.d_hat_2 = json_int(request, "w", 0);
+    parameters.K = json_int(request, "K", 0);
+    parameters.s = json_int(request, "s", 3);
+    parameters.epsilon = 0.0;
+    parameters.stop_option = EXACT_BOUND;
+    parameters.prune_option = RTREE;
+    parameters.num_questions = json_int(request, "q", -1);
+    if (!parse_cmp_option(json_string(request, "cmp", "random"), parameters.cmp_option)
+        || !parse_dom_option(json_string(request, "dom", "hyperplane"), parameters.dom_option)) return false;
+    return parameters.size >= 1 && parameters.d_bar >= 1 && parameters.d_hat >= 1 && parameters.d_hat_2 >= 1
+        && parameters.K >= 1 && parameters.s >= 2 && parameters.num_questions >= 0;
+}
+
+class session_server{
+public:
+    session_server(int num_threads, int speculate, dataset_registry& datasets)
+        : datasets_(datasets), speculate_(speculate), max_speculating_(std::max(1, num_threads - 1)){
+        // the workers divide the cores for the parallel kernels of their requests and speculations
+        int kernel_budget = kernel_threads_per_worker(num_threads);
+        for (int i = 0; i < num_threads; ++i) workers_.emplace_back([this, kernel_budget](){
+            set_thread_kernel_threads(kernel_budget);
+            work();
+        });
+    }
+
+    // queue a request of a session, or answer it right away if it cannot be served
+    void submit(const json_object& request, const std::shared_ptr<client_stream>& client){
+        std::string op = json_string(request, "op");
+        std::string id = json_escape(json_string(request, "session"));
+        if (op != "open" && op != "answer" && op != "close"){
+            client->write(format_error(id, "invalid_request"));
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(id);
+        std::shared_ptr<session_entry> entry;
+        if (op == "open"){
+            if (id.empty() || found != sessions_.end()){
+                client->write(format_error(id, id.empty() ? "invalid_request" : "session_exists"));
+                return;
+            }
+            entry = std::make_shared<session_entry>();
+            entry->id = id;
+            sessions_[id] = entry;
+            opened_++;
+        }
+        else {
+            if (found == sessions_.end()){
+                client->write(format_error(id, "unknown_session"));
+                return;
+            }
+            entry = found->second;
+        }
+        entry->pending.push_back({request, client, std::chrono::steady_clock::now()});
+        if (!entry->busy){
+            entry->busy = true;
+            runnable_.push_back(entry);
+            ready_.notify_one();
+        }
+    }
+
+    std::string stats(){
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<double> recent(recent_.begin(), recent_.end());
+        std::sort(recent.begin(), recent.end());
+        auto percentile = [&](double p){
+            return recent.empty() ? 0 : recent[std::min(recent.size() - 1, size_t(p * recent.size()))];
+        };
+        std::ostringstream out;
+        out << "SERVER_STATS {\"sessions_opened\":" << opened_ << ",\"sessions_finished\":" << finished_
+            << ",\"sessions_active\":" << sessions_.size() << ",";
+        format_latency(out, latency_);
+        out << ",\"p50_latency_ms\":" << percentile(0.5) << ",\"p95_latency_ms\":" << percentile(0.95)
+            << ",\"p99_latency_ms\":" << percentile(0.99) << ",\"speculation_hits\":" << speculation_hits_
+            << ",\"speculation_misses\":" << speculation_misses_ << "}\n";
+        return out.str();
+    }
+
+    // finish the queued requests and stop the workers
+    void stop(){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_) worker.join();
+        workers_.clear();
+    }
+
+    ~session_server(){ stop(); }
+
+private:
+    void work(){
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true){
+            ready_.wait(lock, [this](){
+                return stopping_ || !runnable_.empty() || (!speculative_.empty() && speculating_ < max_speculating_);
+            });
+            if (runnable_.empty()){
+                if (stopping_) return;
+                // speculate only while no request waits, and leave a worker free for the requests that come in
+                std::shared_ptr<speculation> next = speculative_.front();
+                speculative_.pop_front();
+                speculating_++;
+                lock.unlock();
+                if (next->claim()) next->run();
+                lock.lock();
+                speculating_--;
+                continue;
+            }
+            std::shared_ptr<session_entry> entry = runnable_.front();
+            runnable_.pop_front();
+            session_request request = std::move(entry->pending.front());
+            entry->pending.pop_front();
+
+            // the session is held by this worker alone until it is released below
+            lock.unlock();
+            bool ended = false;
+            std::string response = run(*entry, request.request, ended);
+            double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request.received).count();
+            entry->latency.add(latency);
+            if (ended){
+                // the last response of a session carries the latency summary of the session, including its own
+                std::ostringstream out;
+                out << ",";
+                format_latency(out, entry->latency);
+                response.insert(response.size() - 2, out.str());
+            }
+            lock.lock();
+
+            latency_.add(latency);
+            recent_.push_back(latency);
+            if (recent_.size() > LATENCY_WINDOW) recent_.pop_front();
+            std::deque<session_request> dropped;
+            if (ended){
+                for (auto& prepared : entry->speculations) prepared->cancel();
+                entry->speculations.clear();
+                if (entry->session && entry->session->finished() && entry->session->result().error == nullptr) finished_++;
+                sessions_.erase(entry->id);
+                dropped.swap(entry->pending);
+            }
+            // respond before the next request of the session is run, so that its responses stay in order
+            lock.unlock();
+            request.client->write(response);
+            for (auto& rest : dropped) rest.client->write(format_error(entry->id, "unknown_session"));
+            bool speculated = !ended && entry->speculations.empty() && speculate(*entry);
+            lock.lock();
+            if (speculated){
+                // the cancelled speculations of answered questions only leave the queue here, or when a worker is idle
+                speculative_.erase(std::remove_if(speculative_.begin(), speculative_.end(),
+                    [](const std::shared_ptr<speculation>& prepared){ return prepared->cancelled(); }), speculative_.end());
+                speculative_.insert(speculative_.end(), entry->speculations.begin(), entry->speculations.end());
+                ready_.notify_all();
+            }
+            if (!entry->pending.empty()) runnable_.push_back(entry);
+            else entry->busy = false;
+        }
+    }
+
+    // run one request of the session and return its response; ended is set when the session is over
+    std::string run(session_entry& entry, const json_object& request, bool& ended){
+        std::string op = json_string(request, "op");
+        if (op == "close"){
+            ended = true;
+            return "SESSION_CLOSED {\"session\":\"" + entry.id + "\"}\n";
+        }
+        if (op == "open"){
+            highdim_parameters parameters;
+            std::shared_ptr<served_dataset> data;
+            const char* reason = nullptr;
+            int batch = json_int(request, "batch", 0);
+            if (!read_session_parameters(request, parameters) || (request.count("batch") > 0 && batch < 1)) reason = "invalid_request";
+            else if ((data = datasets_.get(json_string(request, "dataset"))) == nullptr) reason = "invalid_dataset";
+            if (reason != nullptr){
+                ended = true;
+                // the session never started, so the error closes it
+                return format_error(entry.id, reason);
+            }
+            unsigned int seed = static_cast<unsigned int>(json_int(request, "seed", 0));
+            // seeded like the generators of an experiment trial with the same seed
+            highdim_random random = {std::mt19937(seed), std::mt19937(seed)};
+            entry.data = data;
+            entry.session.reset(new highdim_session(data->skyline, parameters, random, data->projections.get()));
+            entry.question_budget = parameters.num_questions;
+            entry.batch = batch;
+        }
+        else {
+            // the answer to the pending question, or in a batch session the answers to the first questions of the
+            // last response, in order
+            std::vector<long long> answers;
+            if (request.count("answers") == 0) answers.push_back(json_int(request, "answer", HIGHDIM_NO_CHOICE - 1));
+            else if (entry.batch == 0 || !json_int_list(request, "answers", answers)) answers.clear();
+            bool valid = !answers.empty() && answers.size() <= entry.batched;
+            for (long long answer : answers) valid = valid && answer >= INT_MIN && answer <= INT_MAX;
+            if (!valid) return format_error(entry.id, "invalid_answer");
+            int answer = answers[0];
+            std::shared_ptr<speculation> prepared;
+            for (auto& candidate : entry.speculations){
+                if (candidate->answer == answer && answers.size() == 1) prepared = candidate;
+            }
+            if (prepared){
+                // run it here if no worker has started it yet, otherwise wait for the rest of its work
+                if (prepared->claim()) prepared->run();
+                else prepared->wait();
+                // a speculation that failed the session is not used; the answer is run again on the session
+                if (prepared->session->result().error != nullptr) prepared.reset();
+            }
+            if (answers.size() > 1){
+                if (!entry.session->submit_answers(std::vector<int>(answers.begin(), answers.end()))){
+                    return format_error(entry.id, "invalid_answer");
+                }
+            }
+            else if (prepared){
+                entry.session = std::move(prepared->session);
+                speculation_hits_++;
+            }
+            else if (!entry.session->submit_answer(answer)){
+                return format_error(entry.id, "invalid_answer");
+            }
+            else if (speculate_ > 0){
+                speculation_misses_++;
+            }
+            for (auto& candidate : entry.speculations) candidate->cancel();
+            entry.speculations.clear();
+        }
+        std::string progress = format_progress(entry);
+        ended = entry.session->finished();
+        return progress;
+    }
+
+    // prepare the answers to the pending question of the session, if it has at most speculate_ of them;
+    // false if it has more, or if the question came in a batch, whose answers usually come together
+    bool speculate(session_entry& entry){
+        if (entry.batched > 1) return false;
+        const highdim_question* question = entry.session->next_question();
+        std::vector<int> answers;
+        if (question->dimension_question) answers = {0, 1};
+        else {
+            for (int i = 0; i < question->points.size(); ++i) answers.push_back(i);
+            if (question->allow_none) answers.push_back(HIGHDIM_NO_CHOICE);
+        }
+        if (answers.size() > speculate_) return false;
+        for (int answer : answers){
+            std::shared_ptr<speculation> prepared = std::make_shared<speculation>();
+            prepared->answer = answer;
+            prepared->data = entry.data;
+            prepared->session.reset(entry.session->clone());
+            entry.speculations.push_back(prepared);
+        }
+        return true;
+    }
+
+    dataset_registry& datasets_;
+    size_t speculate_;
+    int max_speculating_;
+    int speculating_ = 0;
+    std::deque<std::shared_ptr<speculation>> speculative_;  // in the order of their questions
+    std::atomic<long> speculation_hits_{0};
+    std::atomic<long> speculation_misses_{0};
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+    std::unordered_map<std::string, std::shared_ptr<session_entry>> sessions_;
+    std::deque<std::shared_ptr<session_entry>> runnable_;  // sessions with pending requests, in arrival order
+    long opened_ = 0;
+    long finished_ = 0;
+    latency_summary latency_;
+    std::deque<double> recent_;
+};
+
+// queue the requests read from in until end of input; false once a shutdown was requested
+bool serve_stream(FILE* in, const std::shared_ptr<client_stream>& client, session_server& server){
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    ssize_t length;
+    bool running = true;
+    while (running && (length = getline(&buffer, &capacity, in)) != -1){
+        std::string line(buffer, length);
+        if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+        json_object request;
+        if (!parse_json_object(line, request)){
+            client->write(format_error("", "invalid_request"));
+            continue;
+        }
+        std::string op = json_string(request, "op");
+        if (op == "shutdown") running = false;
+        else if (op == "stats") client->write(server.stats());
+        else server.submit(request, client);
+    }
+    free(buffer);
+    return running;
+}
+
+int serve_socket(const char* socket_path, session_server& server){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)){
+        std::cerr << "Error: socket path too long: " << socket_path << "\n";
+        return 2;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0){
+        std::cerr << "Error: cannot listen on " << socket_path << "\n";
+        if (listener >= 0) close(listener);
+        return 2;
+    }
+    // a client closing its connection early must not terminate the server
+    signal(SIGPIPE, SIG_IGN);
+
+    // every connection is read on its own thread; sessions are not bound to the connection that opened them
+    std::mutex connections_mutex;
+    std::condition_variable readers_done;
+    std::vector<int> connections;   // the connections being read
+    std::shared_ptr<client_stream> stopped_by;
+    while (true){
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0){
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            if (stopped_by) break;
+            continue;
+        }
+        FILE* in = fdopen(connection, "r");
+        FILE* out = fdopen(dup(connection), "w");
+        if (in == NULL || out == NULL){
+            if (out != NULL) fclose(out);
+            if (in != NULL) fclose(in);
+            else close(connection);
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connections.push_back(connection);
+        std::thread([&, connection, in, out](){
+            std::shared_ptr<client_stream> client = std::make_shared<client_stream>(out, true);
+            bool running = serve_stream(in, client, server);
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            connections.erase(std::find(connections.begin(), connections.end(), connection));
+            fclose(in);
+            if (!running && !stopped_by){
+                stopped_by = client;
+                // wake the accept loop and the readers of the other connections
+                shutdown(listener, SHUT_RDWR);
+                for (int other : connections) shutdown(other, SHUT_RD);
+            }
+            readers_done.notify_all();
+        }).detach();
+    }
+    {
+        std::unique_lock<std::mutex> lock(connections_mutex);
+        readers_done.wait(lock, [&](){ return connections.empty(); });
+    }
+    server.stop();
+    stopped_by->write(server.stats());
+    close(listener);
+    unlink(socket_path);
+    return 0;
+}
+
+} // namespace
+
+int run_session_server(const char* socket_path, int num_threads, int speculate, const std::vector<std::string>& datasets,
+                       int cache_size, bool hull){
+    if (num_threads < 1) num_threads = 1;
+    dataset_registry registry(cache_size, hull);
+    for (const std::string& path : datasets){
+        if (!registry.preload(path)){
+            std::cerr << "Error: cannot read dataset " << path << "\n";
+            return 2;
+        }
+    }
+    session_server server(num_threads, speculate < 0 ? 0 : speculate, registry);
+    if (socket_path != nullptr) return serve_socket(socket_path, server);
+    std::shared_ptr<client_stream> client = std::make_shared<client_stream>(stdout, false);
+    serve_stream(stdin, client, server);
+    server.stop();
+    client->write(server.stats());
+    return 0;
+}
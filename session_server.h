@@ -0,0 +1,40 @@
+#ifndef SESSION_SERVER_H
+#define SESSION_SERVER_H
+
+#include <string>
+#include <vector>
+
+// serve many concurrent interactive sessions over a JSON-lines protocol, one request object per line:
+//   {"op":"open","session":"id","dataset":"path","seed":1,"m":7,"w":6,"K":30,"q":15[,"batch":n]}
+//   {"op":"answer","session":"id","answer":0}
+//   {"op":"answer","session":"id","answers":[0,-1,..]}
+//   {"op":"close","session":"id"}
+//   {"op":"stats"}
+//   {"op":"shutdown"}
+// open and answer are answered with the next question of the session,
+//   SESSION_QUESTION {"session":"id","dimension_question":false,"dimensions":[..],"points":[ids],"values":[[..]],
+//                     "allow_none":true,"remaining_questions":n}
+// in a session opened with a batch, the pending question comes with the phase 1 questions after it, at most n in all,
+// which the user may answer together, or in part, with answers
+//   SESSION_QUESTIONS {"session":"id","questions":[{"dimension_question":false,..,"allow_none":true},..],
+//                      "remaining_questions":n}
+// or, once the session is finished, with its result, after which the session is closed:
+//   SESSION_RESULT {"session":"id","points":[ids],"dimensions":[..],"questions":n,"compute_seconds":x,<latency>}
+// close abandons an unfinished session and is answered with SESSION_CLOSED {"session":"id",<latency>};
+// a request that cannot be served is answered with SESSION_ERROR {"session":"id","reason":"..."}
+// stats and shutdown are answered with SERVER_STATS {<counters>,<latency>} over all sessions
+//
+// while a user thinks about a question with at most speculate possible answers, idle workers answer it in advance
+// on clones of the session, one per answer; the answer that comes in takes its prepared clone, and the others are
+// dropped. With more than one worker, at least one is left to the requests.
+//
+// the datasets are loaded and normalized once, as in experiment mode, and their skylines and phase 3 projections are
+// shared by all sessions. The datasets given on startup are kept; of those that sessions name, the cache_size most
+// recently used are kept, and the others are released after their last session. The requests of one session are run in order; those of different sessions run in parallel
+// on num_threads workers. Requests are read from stdin and answered on stdout, or read from and answered on the
+// connections of a Unix domain socket when socket_path is not null. With hull, the skylines are reduced to the hull
+// vertices of the datasets (see prepare_experiment_dataset).
+int run_session_server(const char* socket_path, int num_threads, int speculate, const std::vector<std::string>& datasets,
+                       int cache_size = 4, bool hull = false);
+
+#endif